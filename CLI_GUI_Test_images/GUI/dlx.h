@@ -0,0 +1,358 @@
+/*******************************************************************************
+*
+*   FILE:           dlx.h
+*
+*   DESCRIPTION:    An exact-cover solver: Knuth's Algorithm X on Dancing
+*                   Links. Given a matrix of 0s and 1s, it finds sets of
+*                   rows that have exactly one 1 in every column.
+*
+*                   The matrix is stored sparsely, one node per 1, each
+*                   linked to its neighbours left, right, up and down. All
+*                   nodes live in a single arena allocated by dlxInit, so a
+*                   search never allocates: covering a column unlinks its
+*                   rows from the other columns, and uncovering relinks them
+*                   in the reverse order.
+*
+*                   Rows can be selected up front (the givens of a puzzle)
+*                   with dlxSelectRow and released with dlxReset, so one
+*                   matrix serves any number of searches. The search always
+*                   branches on the column with the fewest rows left, and
+*                   can try those rows from a random starting point to
+*                   produce random solutions.
+*
+*                   Every function is static inline, so the header can be
+*                   included from any number of source files without a
+*                   separate dlx.c to build and link.
+*
+*   USAGE:          DlxMatrix matrix;
+*                   dlxInit(&matrix, columns, rows, nodes);
+*                   dlxAddRow(&matrix, cols, count);   // once per row
+*                   dlxSelectRow(&matrix, row);        // optional givens
+*                   if (dlxSearch(&matrix, 2, NULL, NULL) == 1) ...
+*                   // matrix.found[0 .. matrix.foundCount) is the solution
+*                   dlxFree(&matrix);
+*
+*   AUTHOR:         hamslices
+*
+********************************************************************************/
+
+#pragma once
+
+#include <stdlib.h>
+
+// One 1 of the matrix. Nodes 1..columns are the column headers and node 0
+// is the root that links the headers of the columns still to be covered.
+typedef struct
+{
+    int left;
+    int right;
+    int up;
+    int down;
+    int column;
+    int row;
+} DlxNode;
+
+// Returns a number in [0, n); used to randomize the search
+typedef int (*DlxRandom)(void* context, int n);
+
+typedef struct
+{
+    DlxNode*      nodes;
+    int*          size;         // rows left in each column
+    int*          rowStart;     // a node of each row
+    int*          chosen;       // rows selected or tried so far, as a stack
+    int*          found;        // rows of the first solution found
+    int           columns;
+    int           rowCount;
+    int           nodeCount;
+    int           maxRows;
+    int           maxNodes;
+    int           depth;        // entries in 'chosen'
+    int           foundCount;
+    unsigned long steps;        // steps the last search took, a measure of difficulty
+    unsigned long stepLimit;    // a search gives up after this many steps (0 = never)
+    int           aborted;      // the last search hit stepLimit
+} DlxMatrix;
+
+// Function Declarations
+static inline int  dlxInit(DlxMatrix* matrix, int columns, int maxRows, int maxNodes);
+static inline void dlxFree(DlxMatrix* matrix);
+static inline int  dlxAddRow(DlxMatrix* matrix, const int* cols, int count);
+static inline void dlxCover(DlxMatrix* matrix, int column);
+static inline void dlxUncover(DlxMatrix* matrix, int column);
+static inline int  dlxSelectRow(DlxMatrix* matrix, int row);
+static inline void dlxReset(DlxMatrix* matrix);
+static inline int  dlxSearch(DlxMatrix* matrix, int limit, DlxRandom random, void* context);
+static inline int  dlxSearchFrom(DlxMatrix* matrix, int limit, DlxRandom random, void* context);
+
+
+// Allocates the arena for a matrix with 'columns' columns and up to
+// 'maxRows' rows holding 'maxNodes' 1s in all. Returns 0 if out of memory.
+static inline int dlxInit(DlxMatrix* matrix, int columns, int maxRows, int maxNodes)
+{
+    matrix->columns = columns;
+    matrix->rowCount = 0;
+    matrix->nodeCount = columns + 1;
+    matrix->maxRows = maxRows;
+    matrix->maxNodes = columns + 1 + maxNodes;
+    matrix->depth = matrix->foundCount = 0;
+    matrix->steps = matrix->stepLimit = 0;
+    matrix->aborted = 0;
+
+    matrix->nodes = malloc(sizeof(DlxNode) * matrix->maxNodes);
+    matrix->size = malloc(sizeof(int) * (columns + 1));
+    matrix->rowStart = malloc(sizeof(int) * maxRows);
+    matrix->chosen = malloc(sizeof(int) * maxRows);
+    matrix->found = malloc(sizeof(int) * maxRows);
+    if (matrix->nodes == NULL || matrix->size == NULL || matrix->rowStart == NULL ||
+        matrix->chosen == NULL || matrix->found == NULL)
+    {
+        dlxFree(matrix);
+        return 0;
+    }
+
+    // The root and the column headers form one circular list
+    for (int i = 0; i <= columns; i++)
+    {
+        DlxNode* node = &matrix->nodes[i];
+        node->left = i == 0 ? columns : i - 1;
+        node->right = i == columns ? 0 : i + 1;
+        node->up = node->down = i;
+        node->column = i;
+        node->row = -1;
+        matrix->size[i] = 0;
+    }
+
+    return 1;
+}
+
+static inline void dlxFree(DlxMatrix* matrix)
+{
+    free(matrix->nodes);
+    free(matrix->size);
+    free(matrix->rowStart);
+    free(matrix->chosen);
+    free(matrix->found);
+    matrix->nodes = NULL;
+    matrix->size = matrix->rowStart = matrix->chosen = matrix->found = NULL;
+}
+
+// Adds a row with 1s in the given columns (1-based, as the headers are)
+// and returns its number, or -1 if the arena is full
+static inline int dlxAddRow(DlxMatrix* matrix, const int* cols, int count)
+{
+    if (matrix->rowCount == matrix->maxRows || matrix->nodeCount + count > matrix->maxNodes || count == 0)
+    {
+        return -1;
+    }
+
+    int row = matrix->rowCount++;
+    int first = matrix->nodeCount;
+    matrix->rowStart[row] = first;
+
+    for (int i = 0; i < count; i++)
+    {
+        int index = matrix->nodeCount++;
+        int column = cols[i];
+        DlxNode* node = &matrix->nodes[index];
+
+        node->column = column;
+        node->row = row;
+        node->left = i == 0 ? first + count - 1 : index - 1;
+        node->right = i == count - 1 ? first : index + 1;
+
+        // Append to the bottom of the column
+        node->down = column;
+        node->up = matrix->nodes[column].up;
+        matrix->nodes[node->up].down = index;
+        matrix->nodes[column].up = index;
+        matrix->size[column]++;
+    }
+
+    return row;
+}
+
+// Takes a column out of the header list and every row that has a 1 in it
+// out of the other columns
+static inline void dlxCover(DlxMatrix* matrix, int column)
+{
+    DlxNode* nodes = matrix->nodes;
+
+    nodes[nodes[column].right].left = nodes[column].left;
+    nodes[nodes[column].left].right = nodes[column].right;
+
+    for (int i = nodes[column].down; i != column; i = nodes[i].down)
+    {
+        for (int j = nodes[i].right; j != i; j = nodes[j].right)
+        {
+            nodes[nodes[j].down].up = nodes[j].up;
+            nodes[nodes[j].up].down = nodes[j].down;
+            matrix->size[nodes[j].column]--;
+        }
+    }
+}
+
+// Undoes dlxCover; the links left in the removed nodes put them back
+static inline void dlxUncover(DlxMatrix* matrix, int column)
+{
+    DlxNode* nodes = matrix->nodes;
+
+    for (int i = nodes[column].up; i != column; i = nodes[i].up)
+    {
+        for (int j = nodes[i].left; j != i; j = nodes[j].left)
+        {
+            matrix->size[nodes[j].column]++;
+            nodes[nodes[j].down].up = j;
+            nodes[nodes[j].up].down = j;
+        }
+    }
+
+    nodes[nodes[column].right].left = column;
+    nodes[nodes[column].left].right = column;
+}
+
+// Puts a row into every solution: covers each of its columns. Returns 0,
+// and changes nothing, if the row clashes with one selected before.
+static inline int dlxSelectRow(DlxMatrix* matrix, int row)
+{
+    DlxNode* nodes = matrix->nodes;
+    int first = matrix->rowStart[row];
+
+    // A column already covered has been taken out of the header list
+    int j = first;
+    do
+    {
+        int column = nodes[j].column;
+        if (nodes[nodes[column].left].right != column)
+        {
+            return 0;
+        }
+        j = nodes[j].right;
+    } while (j != first);
+
+    // Covering the first column unlinks this row's other nodes from their
+    // columns, so it cannot clash with itself
+    j = first;
+    do
+    {
+        dlxCover(matrix, nodes[j].column);
+        j = nodes[j].right;
+    } while (j != first);
+
+    matrix->chosen[matrix->depth++] = first;
+    return 1;
+}
+
+// Releases every selected row, newest first, restoring the full matrix
+static inline void dlxReset(DlxMatrix* matrix)
+{
+    DlxNode* nodes = matrix->nodes;
+
+    while (matrix->depth > 0)
+    {
+        int first = matrix->chosen[--matrix->depth];
+        for (int j = nodes[first].left; ; j = nodes[j].left)
+        {
+            dlxUncover(matrix, nodes[j].column);
+            if (j == first)
+            {
+                break;
+            }
+        }
+    }
+}
+
+// Counts the ways to complete the selected rows to an exact cover,
+// stopping at 'limit'. The first solution's rows, givens included, are
+// left in 'found'. With a 'random' function the rows of each column are
+// tried from a random starting point, so the first solution is a random
+// one. The matrix is left as it was.
+static inline int dlxSearch(DlxMatrix* matrix, int limit, DlxRandom random, void* context)
+{
+    matrix->foundCount = 0;
+    matrix->steps = 0;
+    matrix->aborted = 0;
+    return dlxSearchFrom(matrix, limit, random, context);
+}
+
+static inline int dlxSearchFrom(DlxMatrix* matrix, int limit, DlxRandom random, void* context)
+{
+    DlxNode* nodes = matrix->nodes;
+
+    matrix->steps++;
+    if (matrix->stepLimit != 0 && matrix->steps > matrix->stepLimit)
+    {
+        matrix->aborted = 1;
+        return 0;
+    }
+
+    if (nodes[0].right == 0)
+    {
+        if (matrix->foundCount == 0)
+        {
+            for (int i = 0; i < matrix->depth; i++)
+            {
+                matrix->found[i] = nodes[matrix->chosen[i]].row;
+            }
+            matrix->foundCount = matrix->depth;
+        }
+        return 1; // Every column is covered
+    }
+
+    // Branch on the column with the fewest rows
+    int column = nodes[0].right;
+    for (int c = nodes[column].right; c != 0 && matrix->size[column] > 1; c = nodes[c].right)
+    {
+        if (matrix->size[c] < matrix->size[column])
+        {
+            column = c;
+        }
+    }
+
+    int rows = matrix->size[column];
+    if (rows == 0)
+    {
+        return 0; // Dead end
+    }
+
+    int start = nodes[column].down;
+    if (random != NULL && rows > 1)
+    {
+        for (int skip = random(context, rows); skip > 0; skip--)
+        {
+            start = nodes[start].down;
+        }
+    }
+
+    int count = 0;
+    dlxCover(matrix, column);
+
+    // Every row of the column, from 'start' round to the one above it,
+    // stepping over the header
+    int r = start;
+    for (int tried = 0; tried < rows && count < limit && !matrix->aborted; tried++)
+    {
+        matrix->chosen[matrix->depth++] = r;
+        for (int j = nodes[r].right; j != r; j = nodes[j].right)
+        {
+            dlxCover(matrix, nodes[j].column);
+        }
+
+        count += dlxSearchFrom(matrix, limit - count, random, context);
+
+        for (int j = nodes[r].left; j != r; j = nodes[j].left)
+        {
+            dlxUncover(matrix, nodes[j].column);
+        }
+        matrix->depth--;
+
+        r = nodes[r].down;
+        if (r == column)
+        {
+            r = nodes[column].down;
+        }
+    }
+
+    dlxUncover(matrix, column);
+    return count;
+}
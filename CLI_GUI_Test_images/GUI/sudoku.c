@@ -2,23 +2,78 @@
 *
 *   FILE:           sudoku_generator.c
 *
-*   DESCRIPTION:    This C program generates a solvable Sudoku puzzle of medium
-*                   difficulty. It first creates a fully solved grid and then
-*                   removes a specified number of digits while ensuring a
-*                   single unique solution is maintained.
+*   DESCRIPTION:    This C program generates a solvable Sudoku puzzle. It
+*                   first creates a fully solved grid and then removes digits
+*                   while ensuring a single unique solution is maintained.
 *
-*                   After displaying the puzzle, the program will wait for the
-*                   user to press the Enter key before revealing the solution.
+*                   Without --batch it makes one puzzle from --seed (default:
+*                   the clock), prints it with its grade, waits for the user
+*                   to press the Enter key and then reveals the solution.
 *
-*                   DIFFICULTY ADJUSTMENT:
-*                   The difficulty is controlled by the second argument passed
-*                   to the `removeNumbers()` function in `main()`. A higher
-*                   number means more digits are removed, which generally
-*                   results in a more challenging puzzle.
+*                   BATCH MODE (--batch <count>):
+*                   Generates a whole puzzle book without stopping. Every
+*                   puzzle has its own seed, derived from the book seed and
+*                   its number, and its own random generator, so the puzzles
+*                   are made on all cores at once and a book seed always
+*                   gives the same book. Each puzzle is graded Easy, Medium,
+*                   Hard or Expert by how much searching the solver needs to
+*                   prove it has a single solution.
 *
-*                   - removeNumbers(grid, 40); // Easier
-*                   - removeNumbers(grid, 50); // Medium
-*                   - removeNumbers(grid, 60); // Harder
+*                   The book is laid out for the 1728-dot (8.5") print head:
+*                   puzzles two across, then a solutions section four
+*                   across. It is written a band at a time as 1-bit PBM, or
+*                   as headerless 216-byte print rows (--format raw), to a
+*                   file or to stdout.
+*
+*                   Batch mode never waits for input; the book goes to
+*                   --output (default sudoku_book.pbm or .raw, - for stdout)
+*                   and --threads sets the workers (default one per core).
+*
+*                   DIFFICULTY ADJUSTMENT (--removals <n>):
+*                   The number of digits taken out of each grid. A higher
+*                   number generally results in a more challenging puzzle.
+*                   The default is 50 of 81, and the same share of the cells
+*                   on other sizes.
+*
+*                   - --removals 40 // Easier
+*                   - --removals 50 // Medium
+*                   - --removals 60 // Harder
+*
+*                   Each cell is tried once, in random order, and a digit is
+*                   only removed if the puzzle keeps a single solution. If
+*                   fewer digits can go than were asked for, the program
+*                   says so.
+*
+*                   SOLVER:
+*                   Every search works on a SolverState that keeps, for each
+*                   row, column and 3x3 box, a bitmask of the digits already
+*                   placed there. A cell's candidates are one OR and one NOT
+*                   away, and placing or taking back a digit touches three
+*                   masks. solveSudoku and countSolutions branch on a forced
+*                   cell when a row, column or box has one, and otherwise
+*                   on the empty cell with the fewest candidates.
+*                   generateSudoku fills the empty grid in reading order
+*                   instead. All randomness comes from a SudokuRng passed in
+*                   by the caller; there is no global random state.
+*
+*                   SIZES AND VARIANTS (--size, --variant):
+*                   4x4, 16x16 and 25x25 grids, X-sudoku (each diagonal
+*                   holds every digit once) and jigsaw (irregular regions
+*                   instead of boxes) are generated as exact-cover problems
+*                   with the Dancing Links engine in dlx.h: one matrix row
+*                   per digit in a cell, one column per rule that must hold
+*                   exactly once. Digits above 9 are printed as letters.
+*                   Classic 9x9 puzzles keep the bitmask solver above, so a
+*                   seed gives the same 9x9 puzzle it always did.
+*
+*   REQUIRES:       dlx.h in the same directory; font8x8_basic.h in
+*                   ../Other/common. Link with -pthread on Linux and macOS.
+*
+*   USAGE:          ./sudoku [--seed <n>] [--removals <n>] [--size 4|9|16|25]
+*                            [--variant classic|x|jigsaw]
+*                   ./sudoku --batch <count> [--seed <n>] [--removals <n>]
+*                            [--size 4|9|16|25] [--variant classic|x|jigsaw]
+*                            [--threads <n>] [--format pbm|raw] [--output <file>|->]
 *
 *   AUTHOR:         Generated by Gemini, Google's AI
 *
@@ -26,259 +81,1601 @@
 *
 ********************************************************************************/
 
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L // sysconf
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <limits.h>
+#include <stdint.h>
+#include <ctype.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "../Other/common/font8x8_basic.h"
+#include "dlx.h"
 
 #define N 9
 #define UNASSIGNED 0
+#define ALL_DIGITS 0x3FE // bits 1-9
+
+#define MAX_SIZE 25 // largest grid of the exact-cover generator
+#define MAX_CELLS (MAX_SIZE * MAX_SIZE)
+#define FILL_STEPS_PER_CELL  20ul // search budgets of the exact-cover generator
+#define CARVE_STEPS_PER_CELL 2ul
+#define JIGSAW_ROUNDS        24
+#define FILL_ATTEMPTS        32 // fills tried on each budget before it is doubled
+#define FILL_BUDGETS         4  // budgets tried before the fill is given up
+
+#define PAGE_WIDTH 1728 // dots across the print head
+#define PAGE_STRIDE (PAGE_WIDTH / 8)
+
+// Digits placed so far, one bit per digit (bit 1 = digit 1)
+typedef struct
+{
+    int           cells[N * N];
+    unsigned      rowUsed[N];
+    unsigned      colUsed[N];
+    unsigned      boxUsed[N];
+    unsigned long nodes; // search steps taken, a measure of difficulty
+} SolverState;
+
+// SplitMix64: small, fast and good enough to shuffle digits. Each thread or
+// puzzle owns one.
+typedef struct
+{
+    uint64_t state;
+} SudokuRng;
+
+typedef enum { GRADE_EASY, GRADE_MEDIUM, GRADE_HARD, GRADE_EXPERT } Grade;
+
+typedef enum { VARIANT_CLASSIC, VARIANT_X, VARIANT_JIGSAW } Variant;
+
+// The rules of a puzzle: its size, which region each cell belongs to and
+// whether the diagonals count. Regions are the boxes unless it is a jigsaw.
+typedef struct
+{
+    int           size; // digits, and cells in each row, column and region
+    int           box;  // side of a box, the square root of 'size'
+    Variant       variant;
+    unsigned char region[MAX_CELLS];
+} PuzzleShape;
+
+// Cells are stored row by row, size * size of them
+typedef struct
+{
+    PuzzleShape   shape;
+    int           puzzle[MAX_CELLS];
+    int           solution[MAX_CELLS];
+    int           removed;
+    unsigned long effort;
+    Grade         grade;
+} BookPuzzle;
+
+// The puzzles one worker thread makes: first, first + step, ...
+typedef struct
+{
+    BookPuzzle* puzzles;
+    int         count;
+    int         first;
+    int         step;
+    uint64_t    seed;
+    int         size;
+    Variant     variant;
+    int         removals;
+} BatchJob;
+
+// A strip of the page, 1 bit per dot, MSB first, 1 = black
+typedef struct
+{
+    int            height;
+    unsigned char* bits;
+} RasterBand;
 
 // Function Declarations
-void generateSudoku(int grid[N][N]);
-int  solveSudoku(int grid[N][N]);
-void removeNumbers(int grid[N][N], int difficulty);
+void generateSudoku(int grid[N][N], SudokuRng* rng);
+int  solveSudoku(int grid[N][N], SudokuRng* rng);
+int  removeNumbers(int grid[N][N], int difficulty, SudokuRng* rng);
 int  countSolutions(int grid[N][N]);
-void printGrid(int grid[N][N]);
-int  findUnassignedLocation(int grid[N][N], int* row, int* col);
-int  isSafe(int grid[N][N], int row, int col, int num);
+int  countSolutionsUpTo(int grid[N][N], int limit);
+void printPuzzle(const PuzzleShape* shape, const int* cells);
+char symbolFor(int digit);
+void initSolver(SolverState* state, int grid[N][N]);
+unsigned candidates(const SolverState* state, int cell);
+void toggleDigit(SolverState* state, int cell, int num);
+int  bitCount(unsigned mask);
+int  pickCell(const SolverState* state, unsigned* mask);
+void storeGrid(const SolverState* state, int grid[N][N]);
+void shuffleDigits(int nums[N], SudokuRng* rng);
+int  fillFrom(SolverState* state, int cell, SudokuRng* rng);
+int  solveFrom(SolverState* state, SudokuRng* rng);
+int  countFrom(SolverState* state, int limit);
+uint64_t  rngNext(SudokuRng* rng);
+int       rngBelow(SudokuRng* rng, int n);
+SudokuRng rngForPuzzle(uint64_t seed, int index);
+Grade gradePuzzle(int grid[N][N], unsigned long* effort);
+Grade gradeEffort(unsigned long effort, int size);
+const char* gradeName(Grade grade);
+const char* variantName(Variant variant);
+void initShape(PuzzleShape* shape, int size, Variant variant);
+void makeJigsawRegions(PuzzleShape* shape, const int* solution, SudokuRng* rng);
+int  regionIsConnected(const PuzzleShape* shape, int region);
+int  buildCover(DlxMatrix* matrix, const PuzzleShape* shape);
+int  selectGivens(DlxMatrix* matrix, const PuzzleShape* shape, const int* cells);
+int  rngForSearch(void* context, int n);
+int  makeCoverPuzzle(BookPuzzle* book, int size, Variant variant, int removals, SudokuRng* rng);
+void makeBookPuzzle(BookPuzzle* book, int size, Variant variant, uint64_t seed, int index, int removals);
+void runBatchJob(BatchJob* job);
+void generateBook(BookPuzzle* puzzles, int count, uint64_t seed, int size, Variant variant, int removals, int threads);
+int  defaultThreadCount(void);
+void fillRect(RasterBand* band, int x0, int y0, int x1, int y1);
+void drawText(RasterBand* band, int x, int y, const char* text, int scale);
+void drawPuzzle(RasterBand* band, int x, int y, int cellSize, int digitScale, const PuzzleShape* shape, const int* cells);
+void bookLayout(int size, int pass, int* across, int* cellSize, int* digitScale);
+int  gridDots(int size, int cellSize);
+int  slotBandHeight(int size, int cellSize);
+int  writeBand(FILE* out, RasterBand* band);
+int  writeBook(FILE* out, BookPuzzle* puzzles, int count, uint64_t seed, int pbm);
+int  runBatch(int count, uint64_t seed, int size, Variant variant, int removals, int threads, int pbm, const char* filename);
 
 
-int main() 
+int main(int argc, char* argv[]) 
 {
-    int grid[N][N] = { 0 };
-    int solutionGrid[N][N]; // Array to store the full solution
-    srand(time(0));
+    int         batch = 0;
+    uint64_t    seed = (uint64_t)time(0);
+    int         removals = -1; // default depends on the size
+    int         size = N;
+    Variant     variant = VARIANT_CLASSIC;
+    int         threads = 0;
+    int         pbm = 1;
+    const char* output = NULL;
+    int         argsOk = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc)
+        {
+            batch = atoi(argv[++i]);
+            argsOk = argsOk && batch > 0;
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--removals") == 0 && i + 1 < argc)
+        {
+            removals = atoi(argv[++i]);
+            argsOk = argsOk && removals >= 0;
+        }
+        else if (strcmp(argv[i], "--size") == 0 && i + 1 < argc)
+        {
+            size = atoi(argv[++i]);
+            argsOk = argsOk && (size == 4 || size == 9 || size == 16 || size == 25);
+        }
+        else if (strcmp(argv[i], "--variant") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "classic") == 0)
+            {
+                variant = VARIANT_CLASSIC;
+            }
+            else if (strcmp(argv[i], "x") == 0)
+            {
+                variant = VARIANT_X;
+            }
+            else if (strcmp(argv[i], "jigsaw") == 0)
+            {
+                variant = VARIANT_JIGSAW;
+            }
+            else
+            {
+                argsOk = 0;
+            }
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+        {
+            i++;
+            pbm = strcmp(argv[i], "pbm") == 0;
+            argsOk = argsOk && (pbm || strcmp(argv[i], "raw") == 0);
+        }
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+        {
+            output = argv[++i];
+        }
+        else
+        {
+            argsOk = 0;
+        }
+    }
 
-    // 1. Generate a complete Sudoku solution
-    generateSudoku(grid);
+    if (removals < 0)
+    {
+        removals = size * size * 50 / (N * N); // 50 of 81, the same share on every size
+    }
 
-    // 2. Save the complete solution before removing numbers
-    for (int i = 0; i < N; i++)
+    if (!argsOk || removals > size * size)
     {
-        for (int j = 0; j < N; j++)
+        fprintf(stderr, "Usage: %s [--seed <n>] [--removals <n>] [--size 4|9|16|25] [--variant classic|x|jigsaw]\n", argv[0]);
+        fprintf(stderr, "       %s --batch <count> [--seed <n>] [--removals <n>] [--size 4|9|16|25]\n", argv[0]);
+        fprintf(stderr, "           [--variant classic|x|jigsaw] [--threads <n>] [--format pbm|raw] [--output <file>|-]\n");
+        fprintf(stderr, "  --batch     Make a printable book of this many puzzles, no questions asked\n");
+        fprintf(stderr, "  --seed      Same seed, same puzzles (default: the clock)\n");
+        fprintf(stderr, "  --removals  Digits to take out of each grid (default 50 of 81, the same share on\n");
+        fprintf(stderr, "              other sizes; 40 easier, 60 harder)\n");
+        fprintf(stderr, "  --size      Digits per row: 4, 9 (default), 16 or 25\n");
+        fprintf(stderr, "  --variant   classic (default), x: diagonals too, jigsaw: irregular regions\n");
+        fprintf(stderr, "  --threads   Workers for --batch (0 = one per core, default)\n");
+        fprintf(stderr, "  --format    pbm: 1-bit PBM (default), raw: headerless 216-byte print rows\n");
+        fprintf(stderr, "  --output    Book file, - for stdout (default sudoku_book.pbm or .raw)\n");
+        return 1;
+    }
+
+    if (batch > 0)
+    {
+        if (output == NULL)
         {
-            solutionGrid[i][j] = grid[i][j];
+            output = pbm ? "sudoku_book.pbm" : "sudoku_book.raw";
         }
+        return runBatch(batch, seed, size, variant, removals, threads > 0 ? threads : defaultThreadCount(), pbm, output);
     }
 
-    // 3. Remove numbers to create the puzzle
-    removeNumbers(grid, 50);
+    // 1. Generate a complete solution and remove numbers to create the puzzle
+    BookPuzzle book;
+    makeBookPuzzle(&book, size, variant, seed, 0, removals);
+    if (book.removed < removals)
+    {
+        printf("Only %d digits could be removed while keeping a single solution.\n", book.removed);
+    }
 
-    // 4. Print the generated puzzle
-    printf("Generated Medium Difficulty Sudoku Puzzle:\n");
-    printGrid(grid);
+    // 2. Print the generated puzzle
+    if (size == N && variant == VARIANT_CLASSIC)
+    {
+        printf("Generated %s Sudoku Puzzle (seed %llu):\n", gradeName(book.grade), (unsigned long long)seed);
+    }
+    else
+    {
+        printf("Generated %s %dx%d %s Puzzle (seed %llu):\n", gradeName(book.grade), size, size,
+            variantName(variant), (unsigned long long)seed);
+    }
+    printPuzzle(&book.shape, book.puzzle);
 
-    // 5. Prompt user and wait for input before showing the solution
+    // 3. Prompt user and wait for input before showing the solution
     printf("\nPress Enter to reveal the solution...");
     getchar(); // Waits for the user to press the Enter key
 
-    // 6. Print the saved solution
+    // 4. Print the saved solution
     printf("\n\nSolution:\n");
-    printGrid(solutionGrid);
+    printPuzzle(&book.shape, book.solution);
 
     return 0;
 }
 
-// Generates a full Sudoku board by solving an empty one
-void generateSudoku(int grid[N][N]) 
+// Generates a full Sudoku board by filling an empty one
+void generateSudoku(int grid[N][N], SudokuRng* rng) 
 {
-    solveSudoku(grid);
+    SolverState state;
+    initSolver(&state, grid);
+
+    if (fillFrom(&state, 0, rng))
+    {
+        storeGrid(&state, grid);
+    }
 }
 
-// Finds the first unassigned (0) location in the grid
-int findUnassignedLocation(int grid[N][N], int* row, int* col) 
+// Loads a grid into the solver state, marking every given digit
+void initSolver(SolverState* state, int grid[N][N])
 {
-    for (*row = 0; *row < N; (*row)++) 
+    for (int i = 0; i < N; i++)
+    {
+        state->rowUsed[i] = state->colUsed[i] = state->boxUsed[i] = 0;
+    }
+    state->nodes = 0;
+
+    for (int row = 0; row < N; row++)
     {
-        for (*col = 0; *col < N; (*col)++)
+        for (int col = 0; col < N; col++)
         {
-            if (grid[*row][*col] == UNASSIGNED)
+            int num = grid[row][col];
+            state->cells[row * N + col] = num;
+            if (num != UNASSIGNED)
             {
-                return 1;
+                state->rowUsed[row] |= 1u << num;
+                state->colUsed[col] |= 1u << num;
+                state->boxUsed[(row / 3) * 3 + col / 3] |= 1u << num;
             }
         }
     }
+}
 
-    return 0;
+// Digits that can still go in a cell, as a bitmask
+unsigned candidates(const SolverState* state, int cell)
+{
+    int row = cell / N;
+    int col = cell % N;
+    return ~(state->rowUsed[row] | state->colUsed[col] | state->boxUsed[(row / 3) * 3 + col / 3]) & ALL_DIGITS;
+}
+
+// Toggles a digit in or out of a cell; calling it twice undoes the move
+void toggleDigit(SolverState* state, int cell, int num)
+{
+    int row = cell / N;
+    int col = cell % N;
+    unsigned bit = 1u << num;
+
+    state->cells[cell] = state->cells[cell] == UNASSIGNED ? num : UNASSIGNED;
+    state->rowUsed[row] ^= bit;
+    state->colUsed[col] ^= bit;
+    state->boxUsed[(row / 3) * 3 + col / 3] ^= bit;
 }
 
-// Checks if a number is already used in a row
-int usedInRow(int grid[N][N], int row, int num) 
+int bitCount(unsigned mask)
 {
-    for (int col = 0; col < N; col++)
+    int count = 0;
+    for (; mask != 0; mask &= mask - 1)
     {
-        if (grid[row][col] == num)
-        {
-            return 1;
-        }
+        count++;
     }
 
-    return 0;
+    return count;
 }
 
-// Checks if a number is already used in a column
-int usedInCol(int grid[N][N], int col, int num)
+// Finds the cell to branch on and returns it, with the digits to try in
+// 'mask' (0 means a dead end). Returns -1 when the grid is full.
+//
+// That is the empty cell with the fewest candidates, unless some row,
+// column or box has a digit that fits only one of its cells: that cell is
+// forced, and only that digit is tried.
+int pickCell(const SolverState* state, unsigned* mask)
 {
-    for (int row = 0; row < N; row++) 
+    int best = -1;
+    int bestCount = N + 1;
+
+    for (int cell = 0; cell < N * N; cell++)
     {
-        if (grid[row][col] == num)
+        if (state->cells[cell] != UNASSIGNED)
         {
-            return 1;
+            continue;
+        }
+
+        unsigned allowed = candidates(state, cell);
+        int count = bitCount(allowed);
+        if (count < bestCount)
+        {
+            best = cell;
+            bestCount = count;
+            *mask = allowed;
+            if (count <= 1)
+            {
+                break; // Dead end, or a forced move
+            }
         }
     }
 
-    return 0;
-}
+    if (bestCount <= 1)
+    {
+        return best;
+    }
 
-// Checks if a number is already used in a 3x3 box
-int usedInBox(int grid[N][N], int boxStartRow, int boxStartCol, int num) 
-{
-    for (int row = 0; row < 3; row++) 
+    // Units 0-8 are rows, 9-17 columns and 18-26 boxes
+    for (int unit = 0; unit < 3 * N; unit++)
     {
-        for (int col = 0; col < 3; col++) 
+        int      unitCells[N];
+        unsigned once = 0, twice = 0, placed = 0;
+
+        for (int i = 0; i < N; i++)
         {
-            if (grid[row + boxStartRow][col + boxStartCol] == num) 
+            int row, col;
+            if (unit < N)
             {
-                return 1;
+                row = unit;
+                col = i;
+            }
+            else if (unit < 2 * N)
+            {
+                row = i;
+                col = unit - N;
+            }
+            else
+            {
+                row = ((unit - 2 * N) / 3) * 3 + i / 3;
+                col = ((unit - 2 * N) % 3) * 3 + i % 3;
+            }
+
+            int cell = row * N + col;
+            unitCells[i] = cell;
+            if (state->cells[cell] != UNASSIGNED)
+            {
+                placed |= 1u << state->cells[cell];
+                continue;
+            }
+
+            unsigned allowed = candidates(state, cell);
+            twice |= once & allowed;
+            once  |= allowed;
+        }
+
+        unsigned missing = ALL_DIGITS & ~placed;
+        if (missing & ~once)
+        {
+            *mask = 0;
+            return best; // A digit has nowhere to go
+        }
+
+        unsigned single = missing & once & ~twice;
+        if (single != 0)
+        {
+            unsigned bit = single & (0u - single); // Lowest such digit
+            for (int i = 0; i < N; i++)
+            {
+                if (state->cells[unitCells[i]] == UNASSIGNED && (candidates(state, unitCells[i]) & bit))
+                {
+                    *mask = bit;
+                    return unitCells[i];
+                }
             }
         }
     }
 
-    return 0;
+    return best;
 }
 
-// Checks if it is safe to place a number in a given cell
-int isSafe(int grid[N][N], int row, int col, int num) 
+// Copies the solver's cells back into a grid
+void storeGrid(const SolverState* state, int grid[N][N])
 {
-    return !usedInRow(grid, row, num) &&
-        !usedInCol(grid, col, num) &&
-        !usedInBox(grid, row - row % 3, col - col % 3, num) &&
-        grid[row][col] == UNASSIGNED;
+    for (int cell = 0; cell < N * N; cell++)
+    {
+        grid[cell / N][cell % N] = state->cells[cell];
+    }
 }
 
-// Solves the Sudoku using a randomized backtracking algorithm
-int solveSudoku(int grid[N][N]) 
+// Randomizes the order the digits are tried in, creating different puzzles each time
+void shuffleDigits(int nums[N], SudokuRng* rng)
 {
-    int row, col;
+    for (int i = 0; i < N; i++)
+    {
+        int j = rngBelow(rng, N);
+        int temp = nums[i];
+        nums[i]  = nums[j];
+        nums[j]  = temp;
+    }
+}
 
-    if (!findUnassignedLocation(grid, &row, &col))
+// Randomized backtracking from 'cell' onwards in reading order. On an
+// empty grid this never has to back up far.
+int fillFrom(SolverState* state, int cell, SudokuRng* rng)
+{
+    while (cell < N * N && state->cells[cell] != UNASSIGNED)
     {
-        return 1; // Puzzle is solved
+        cell++;
     }
 
-    int nums[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
-    // Randomize the numbers to try, creating different puzzles each time
-    for (int i = 0; i < N; i++) 
+    if (cell == N * N)
     {
-        int j = rand() % N;
-        int temp = nums[i];
-        nums[i]  = nums[j];
-        nums[j]  = temp;
+        return 1; // Grid is full
     }
 
-    for (int i = 0; i < N; i++) 
+    int nums[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    shuffleDigits(nums, rng);
+
+    unsigned allowed = candidates(state, cell);
+    for (int i = 0; i < N; i++)
     {
         int num = nums[i];
-        if (isSafe(grid, row, col, num)) 
+        if (allowed & (1u << num))
         {
-            grid[row][col] = num;
+            toggleDigit(state, cell, num);
 
-            if (solveSudoku(grid))
+            if (fillFrom(state, cell + 1, rng))
             {
                 return 1;
             }
 
-            grid[row][col] = UNASSIGNED; // Backtrack
+            toggleDigit(state, cell, num); // Backtrack
         }
     }
 
     return 0;
 }
 
-// Removes 'count' numbers from a full grid to create a puzzle
-void removeNumbers(int grid[N][N], int count) 
+// Randomized backtracking on the most constrained cell first
+int solveFrom(SolverState* state, SudokuRng* rng)
 {
-    while (count > 0) {
-        int row = rand() % N;
-        int col = rand() % N;
+    unsigned allowed = 0;
+    int cell = pickCell(state, &allowed);
+    state->nodes++;
+
+    if (cell < 0)
+    {
+        return 1; // Puzzle is solved
+    }
+
+    int nums[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    shuffleDigits(nums, rng);
 
-        if (grid[row][col] != UNASSIGNED) 
+    for (int i = 0; i < N; i++)
+    {
+        int num = nums[i];
+        if (allowed & (1u << num))
         {
-            int temp = grid[row][col];
-            grid[row][col] = UNASSIGNED;
+            toggleDigit(state, cell, num);
 
-            int tempGrid[N][N];
-            for (int i = 0; i < N; i++) 
+            if (solveFrom(state, rng))
             {
-                for (int j = 0; j < N; j++)
-                {
-                    tempGrid[i][j] = grid[i][j];
-                }
+                return 1;
             }
 
-            if (countSolutions(tempGrid) != 1) 
-            {
-                // If removing the number makes the puzzle have non-unique solutions,
-                // put it back.
-                grid[row][col] = temp;
-            }
-            else 
-            {
-                count--;
-            }
+            toggleDigit(state, cell, num); // Backtrack
+        }
+    }
+
+    return 0;
+}
+
+// Solves the Sudoku using a randomized backtracking algorithm
+int solveSudoku(int grid[N][N], SudokuRng* rng)
+{
+    SolverState state;
+    initSolver(&state, grid);
+
+    if (!solveFrom(&state, rng))
+    {
+        return 0;
+    }
+
+    storeGrid(&state, grid);
+    return 1;
+}
+
+// Removes up to 'count' numbers from a full grid to create a puzzle, keeping
+// the solution unique. Every cell is tried once, in random order, so the
+// work is bounded: at most 81 uniqueness checks, each stopping at the second
+// solution. Returns how many numbers were removed, which is less than
+// 'count' when no further cell can go.
+int removeNumbers(int grid[N][N], int count, SudokuRng* rng) 
+{
+    int order[N * N];
+    for (int i = 0; i < N * N; i++)
+    {
+        order[i] = i;
+    }
+
+    for (int i = N * N - 1; i > 0; i--)
+    {
+        int j = rngBelow(rng, i + 1);
+        int temp = order[i];
+        order[i] = order[j];
+        order[j] = temp;
+    }
+
+    // The puzzle so far; each probe takes a digit out and the search leaves
+    // the state as it found it
+    SolverState state;
+    initSolver(&state, grid);
+
+    int removed = 0;
+    for (int i = 0; i < N * N && removed < count; i++)
+    {
+        int cell = order[i];
+        int num = state.cells[cell];
+        if (num == UNASSIGNED)
+        {
+            continue;
+        }
+
+        toggleDigit(&state, cell, num);
+        if (countFrom(&state, 2) != 1)
+        {
+            // If removing the number makes the puzzle have non-unique solutions,
+            // put it back.
+            toggleDigit(&state, cell, num);
+        }
+        else
+        {
+            removed++;
         }
     }
+
+    storeGrid(&state, grid);
+    return removed;
 }
 
-// Counts the number of solutions for a given grid state
-int countSolutions(int grid[N][N]) {
-    int row, col;
-    int count = 0;
+// Counts solutions, always branching on the most constrained empty cell.
+// Stops as soon as 'limit' solutions have been found.
+int countFrom(SolverState* state, int limit)
+{
+    unsigned allowed = 0;
+    int cell = pickCell(state, &allowed);
+    state->nodes++;
 
-    if (!findUnassignedLocation(grid, &row, &col)) 
+    if (cell < 0)
     {
         return 1; // A solution is found
     }
 
-    for (int num = 1; num <= 9; num++) 
+    int count = 0;
+    for (int num = 1; num <= 9 && count < limit; num++)
     {
-        if (isSafe(grid, row, col, num)) 
+        if (allowed & (1u << num))
         {
-            grid[row][col] = num;
-            count += countSolutions(grid);
-            grid[row][col] = UNASSIGNED; // Backtrack
+            toggleDigit(state, cell, num);
+            count += countFrom(state, limit - count);
+            toggleDigit(state, cell, num); // Backtrack
         }
     }
 
     return count;
 }
 
-// Prints the Sudoku grid in a formatted way
-void printGrid(int grid[N][N]) 
+// Counts the number of solutions for a given grid state
+int countSolutions(int grid[N][N])
 {
-    for (int row = 0; row < N; row++)
+    SolverState state;
+    initSolver(&state, grid);
+    return countFrom(&state, INT_MAX);
+}
+
+// Counts solutions up to 'limit'; countSolutionsUpTo(grid, 2) == 1 means
+// the solution is unique
+int countSolutionsUpTo(int grid[N][N], int limit)
+{
+    SolverState state;
+    initSolver(&state, grid);
+    return countFrom(&state, limit);
+}
+
+// Prints the puzzle in a formatted way. Boxes are ruled off; a jigsaw
+// puzzle has its regions printed as letters beside the grid instead.
+void printPuzzle(const PuzzleShape* shape, const int* cells)
+{
+    int n = shape->size;
+    int boxed = shape->variant != VARIANT_JIGSAW;
+
+    for (int row = 0; row < n; row++)
     {
-        if (row % 3 == 0 && row != 0)
+        if (boxed && row % shape->box == 0 && row != 0)
         {
-            printf("---------------------\n");
+            for (int i = 0; i < 2 * n + 2 * (shape->box - 1) - 1; i++)
+            {
+                putchar('-');
+            }
+            printf("\n");
         }
 
-        for (int col = 0; col < N; col++) 
+        for (int col = 0; col < n; col++) 
         {
-            if (col % 3 == 0 && col != 0) 
+            if (boxed && col % shape->box == 0 && col != 0) 
             {
                 printf("| ");
             }
 
-            if (grid[row][col] == UNASSIGNED) 
-            {
-                printf(". ");
-            }
-            else 
+            int digit = cells[row * n + col];
+            printf("%c ", digit == UNASSIGNED ? '.' : symbolFor(digit));
+        }
+
+        if (!boxed)
+        {
+            printf("   ");
+            for (int col = 0; col < n; col++)
             {
-                printf("%d ", grid[row][col]);
+                printf("%c ", 'a' + shape->region[row * n + col]);
             }
         }
         printf("\n");
     }
-}
\ No newline at end of file
+}
+
+// 1-9, then letters for the digits of larger grids
+char symbolFor(int digit)
+{
+    return "0123456789ABCDEFGHIJKLMNOP"[digit];
+}
+
+// Next 64 random bits (SplitMix64)
+uint64_t rngNext(SudokuRng* rng)
+{
+    uint64_t z = (rng->state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// A number in [0, n)
+int rngBelow(SudokuRng* rng, int n)
+{
+    return (int)(((rngNext(rng) >> 32) * (uint64_t)n) >> 32);
+}
+
+// The generator for puzzle 'index' of the book with this seed. Puzzles get
+// unrelated streams, so each one depends only on the seed and its number.
+SudokuRng rngForPuzzle(uint64_t seed, int index)
+{
+    SudokuRng mixer = { (uint64_t)index };
+    SudokuRng rng = { seed ^ rngNext(&mixer) };
+    rngNext(&rng);
+    return rng;
+}
+
+// Grades a puzzle by the search steps needed to solve it and prove the
+// solution is the only one. A puzzle that never needs a guess takes one
+// step per empty cell, plus one, so up to 45 blanks without guessing is
+// Easy and a few guesses on top of 50 blanks is still Medium.
+Grade gradePuzzle(int grid[N][N], unsigned long* effort)
+{
+    SolverState state;
+    initSolver(&state, grid);
+    countFrom(&state, 2);
+    *effort = state.nodes;
+
+    return gradeEffort(state.nodes, N);
+}
+
+// Grades the search steps of a puzzle against limits per 81 cells for its
+// size. The 9x9 limits were set on the bitmask solver; the exact-cover
+// search takes the same number of steps on a 9x9 grid, so they serve 9x9
+// X and jigsaw too. 16x16 and 25x25 grids are carved until the proof of
+// uniqueness nearly fills its budget (CARVE_STEPS_PER_CELL, 162 steps per
+// 81 cells), so their limits sit higher and closer together. They were
+// measured on sample books so that a share of removals gives about the mix
+// of grades it gives on 9x9, and Expert means the whole budget was used.
+// A 4x4 grid never needs a guess; its grade follows --removals alone.
+Grade gradeEffort(unsigned long effort, int size)
+{
+    static const struct
+    {
+        int           size;
+        unsigned long easy;
+        unsigned long medium;
+        unsigned long hard;
+    } limits[] = {
+        { 4,  46,  56,  120 },
+        { 9,  46,  56,  120 },
+        { 16, 64,  148, 161 },
+        { 25, 145, 157, 161 },
+    };
+    int cells = size * size;
+    int i = 0;
+    while (i < (int)(sizeof(limits) / sizeof(limits[0])) - 1 && limits[i].size < size)
+    {
+        i++;
+    }
+
+    if (effort <= limits[i].easy * cells / (N * N))
+    {
+        return GRADE_EASY;
+    }
+    if (effort <= limits[i].medium * cells / (N * N))
+    {
+        return GRADE_MEDIUM;
+    }
+    if (effort <= limits[i].hard * cells / (N * N))
+    {
+        return GRADE_HARD;
+    }
+    return GRADE_EXPERT;
+}
+
+const char* gradeName(Grade grade)
+{
+    switch (grade)
+    {
+    case GRADE_EASY:   return "Easy";
+    case GRADE_MEDIUM: return "Medium";
+    case GRADE_HARD:   return "Hard";
+    default:           return "Expert";
+    }
+}
+
+const char* variantName(Variant variant)
+{
+    switch (variant)
+    {
+    case VARIANT_X:      return "X-Sudoku";
+    case VARIANT_JIGSAW: return "Jigsaw Sudoku";
+    default:             return "Sudoku";
+    }
+}
+
+// Sets up the rules of a puzzle, with the boxes as its regions
+void initShape(PuzzleShape* shape, int size, Variant variant)
+{
+    shape->size = size;
+    shape->box = 1;
+    while (shape->box * shape->box < size)
+    {
+        shape->box++;
+    }
+    shape->variant = variant;
+
+    for (int cell = 0; cell < size * size; cell++)
+    {
+        int row = cell / size;
+        int col = cell % size;
+        shape->region[cell] = (unsigned char)((row / shape->box) * shape->box + col / shape->box);
+    }
+}
+
+// Turns the regions of a solved grid into jigsaw pieces. A cell joins the
+// region next to it, and the cell of that region holding the same digit
+// moves the other way, so every region still holds each digit once and
+// the grid stays solved. Trades that would split a region are undone.
+//
+// Filling an empty jigsaw grid instead is hopeless beyond 9x9: most
+// random layouts of 16x16 and larger take millions of search steps.
+void makeJigsawRegions(PuzzleShape* shape, const int* solution, SudokuRng* rng)
+{
+    const int dRow[4] = { -1, 0, 1, 0 };
+    const int dCol[4] = { 0, 1, 0, -1 };
+    int n = shape->size;
+    int cells = n * n;
+    int trades = 0;
+
+    // The cell of each region holding each digit
+    int where[MAX_CELLS];
+    for (int cell = 0; cell < cells; cell++)
+    {
+        where[shape->region[cell] * n + solution[cell] - 1] = cell;
+    }
+
+    for (int tries = 0; trades < 4 * cells && tries < 400 * cells; tries++)
+    {
+        int a = rngBelow(rng, cells);
+        int side = rngBelow(rng, 4);
+        int row = a / n + dRow[side];
+        int col = a % n + dCol[side];
+        if (row < 0 || row >= n || col < 0 || col >= n)
+        {
+            continue;
+        }
+
+        int regionA = shape->region[a];
+        int regionB = shape->region[row * n + col];
+        if (regionA == regionB)
+        {
+            continue;
+        }
+
+        // The cell going back must touch region A somewhere other than 'a'
+        int give = where[regionB * n + solution[a] - 1];
+        int touches = 0;
+        for (int s = 0; s < 4; s++)
+        {
+            int r2 = give / n + dRow[s];
+            int c2 = give % n + dCol[s];
+            touches = touches || (r2 >= 0 && r2 < n && c2 >= 0 && c2 < n && r2 * n + c2 != a &&
+                shape->region[r2 * n + c2] == regionA);
+        }
+        if (!touches)
+        {
+            continue;
+        }
+
+        shape->region[a] = (unsigned char)regionB;
+        shape->region[give] = (unsigned char)regionA;
+        if (regionIsConnected(shape, regionA) && regionIsConnected(shape, regionB))
+        {
+            where[regionB * n + solution[a] - 1] = a;
+            where[regionA * n + solution[a] - 1] = give;
+            trades++;
+        }
+        else
+        {
+            shape->region[a] = (unsigned char)regionA;
+            shape->region[give] = (unsigned char)regionB;
+        }
+    }
+}
+
+// Flood fills the region from one of its cells and checks it reaches all
+// of them
+int regionIsConnected(const PuzzleShape* shape, int region)
+{
+    int n = shape->size;
+    int stack[MAX_CELLS];
+    unsigned char seen[MAX_CELLS] = { 0 };
+    int top = 0;
+    int reached = 0;
+
+    for (int cell = 0; cell < n * n && top == 0; cell++)
+    {
+        if (shape->region[cell] == region)
+        {
+            stack[top++] = cell;
+            seen[cell] = 1;
+        }
+    }
+
+    while (top > 0)
+    {
+        int cell = stack[--top];
+        int row = cell / n;
+        int col = cell % n;
+        int next[4] = { row > 0 ? cell - n : -1, col + 1 < n ? cell + 1 : -1,
+                        row + 1 < n ? cell + n : -1, col > 0 ? cell - 1 : -1 };
+        reached++;
+
+        for (int s = 0; s < 4; s++)
+        {
+            if (next[s] >= 0 && !seen[next[s]] && shape->region[next[s]] == region)
+            {
+                seen[next[s]] = 1;
+                stack[top++] = next[s];
+            }
+        }
+    }
+
+    return reached == n;
+}
+
+// The puzzle as an exact-cover matrix. Row cell * size + digit - 1 puts
+// 'digit' in 'cell'; every cell, and every digit in every row, column,
+// region and (for X-sudoku) diagonal, is one column that must be covered
+// exactly once. Returns 0 if out of memory.
+int buildCover(DlxMatrix* matrix, const PuzzleShape* shape)
+{
+    int n = shape->size;
+    int cells = n * n;
+    int diagonals = shape->variant == VARIANT_X;
+
+    if (!dlxInit(matrix, 4 * cells + (diagonals ? 2 * n : 0), cells * n, cells * n * 6))
+    {
+        return 0;
+    }
+
+    for (int cell = 0; cell < cells; cell++)
+    {
+        int row = cell / n;
+        int col = cell % n;
+        for (int d = 0; d < n; d++)
+        {
+            int cols[6];
+            int count = 0;
+            cols[count++] = 1 + cell;
+            cols[count++] = 1 + cells + row * n + d;
+            cols[count++] = 1 + 2 * cells + col * n + d;
+            cols[count++] = 1 + 3 * cells + shape->region[cell] * n + d;
+            if (diagonals && row == col)
+            {
+                cols[count++] = 1 + 4 * cells + d;
+            }
+            if (diagonals && row + col == n - 1)
+            {
+                cols[count++] = 1 + 4 * cells + n + d;
+            }
+            dlxAddRow(matrix, cols, count);
+        }
+    }
+
+    return 1;
+}
+
+// Selects the row of every digit already in the grid. Returns 0 if two of
+// them clash.
+int selectGivens(DlxMatrix* matrix, const PuzzleShape* shape, const int* cells)
+{
+    int n = shape->size;
+    for (int cell = 0; cell < n * n; cell++)
+    {
+        if (cells[cell] != UNASSIGNED && !dlxSelectRow(matrix, cell * n + cells[cell] - 1))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+int rngForSearch(void* context, int n)
+{
+    return rngBelow((SudokuRng*)context, n);
+}
+
+// Makes a puzzle of any size or variant on the exact-cover engine: a
+// random search on the empty matrix fills the grid, then cells are removed
+// in random order while a search with the rest selected still finds just
+// one solution. Each of those searches has a step budget; a digit whose
+// removal cannot be proven safe within it stays, which keeps 25x25 grids
+// from stalling on a few hard proofs. A jigsaw is filled with boxes and
+// reshaped afterwards. Returns 1 on success, 0 if out of memory and -1 if
+// no fill finished within any budget.
+int makeCoverPuzzle(BookPuzzle* book, int size, Variant variant, int removals, SudokuRng* rng)
+{
+    int cells = size * size;
+    DlxMatrix matrix;
+
+    initShape(&book->shape, size, variant == VARIANT_JIGSAW ? VARIANT_CLASSIC : variant);
+    if (!buildCover(&matrix, &book->shape))
+    {
+        return 0;
+    }
+
+    // A fill that wanders into a dead end for too long starts over; one
+    // that keeps doing so gets a bigger budget, and in the end an error
+    int filled = 0;
+    for (int budget = 0; budget < FILL_BUDGETS && !filled; budget++)
+    {
+        matrix.stepLimit = (FILL_STEPS_PER_CELL * cells) << budget;
+        for (int attempt = 0; attempt < FILL_ATTEMPTS && !filled; attempt++)
+        {
+            filled = dlxSearch(&matrix, 1, rngForSearch, rng) == 1;
+        }
+    }
+    if (!filled)
+    {
+        dlxFree(&matrix);
+        return -1;
+    }
+
+    for (int i = 0; i < matrix.foundCount; i++)
+    {
+        int row = matrix.found[i];
+        book->solution[row / size] = row % size + 1;
+    }
+    memcpy(book->puzzle, book->solution, sizeof(int) * cells);
+
+    // Trades alone soon run out of cells holding the right digits, so
+    // between rounds half the grid is kept and the rest solved afresh
+    if (variant == VARIANT_JIGSAW)
+    {
+        book->shape.variant = VARIANT_JIGSAW;
+        for (int round = 0; round < JIGSAW_ROUNDS; round++)
+        {
+            makeJigsawRegions(&book->shape, book->solution, rng);
+            dlxFree(&matrix);
+            if (!buildCover(&matrix, &book->shape))
+            {
+                return 0;
+            }
+
+            matrix.stepLimit = FILL_STEPS_PER_CELL * cells;
+            for (int cell = 0; cell < cells; cell++)
+            {
+                book->puzzle[cell] = rngBelow(rng, 2) ? book->solution[cell] : UNASSIGNED;
+            }
+            selectGivens(&matrix, &book->shape, book->puzzle);
+            if (dlxSearch(&matrix, 1, rngForSearch, rng) == 1)
+            {
+                for (int i = 0; i < matrix.foundCount; i++)
+                {
+                    int row = matrix.found[i];
+                    book->solution[row / size] = row % size + 1;
+                }
+            }
+            dlxReset(&matrix);
+        }
+        memcpy(book->puzzle, book->solution, sizeof(int) * cells);
+    }
+    matrix.stepLimit = CARVE_STEPS_PER_CELL * cells;
+
+    int order[MAX_CELLS];
+    for (int i = 0; i < cells; i++)
+    {
+        order[i] = i;
+    }
+    for (int i = cells - 1; i > 0; i--)
+    {
+        int j = rngBelow(rng, i + 1);
+        int temp = order[i];
+        order[i] = order[j];
+        order[j] = temp;
+    }
+
+    book->removed = 0;
+    for (int i = 0; i < cells && book->removed < removals; i++)
+    {
+        int cell = order[i];
+        int num = book->puzzle[cell];
+        book->puzzle[cell] = UNASSIGNED;
+
+        dlxReset(&matrix);
+        selectGivens(&matrix, &book->shape, book->puzzle);
+        if (dlxSearch(&matrix, 2, NULL, NULL) != 1 || matrix.aborted)
+        {
+            book->puzzle[cell] = num; // Not unique without it, or not provably
+        }
+        else
+        {
+            book->removed++;
+        }
+    }
+
+    // The same search as the last removal that stood, so it stays in budget
+    dlxReset(&matrix);
+    selectGivens(&matrix, &book->shape, book->puzzle);
+    dlxSearch(&matrix, 2, NULL, NULL);
+    book->effort = matrix.steps;
+    book->grade = gradeEffort(book->effort, size);
+
+    dlxFree(&matrix);
+    return 1;
+}
+
+// Makes puzzle 'index' of a book. Classic 9x9 puzzles use the bitmask
+// solver, everything else the exact-cover engine.
+void makeBookPuzzle(BookPuzzle* book, int size, Variant variant, uint64_t seed, int index, int removals)
+{
+    SudokuRng rng = rngForPuzzle(seed, index);
+
+    if (size != N || variant != VARIANT_CLASSIC)
+    {
+        int made = makeCoverPuzzle(book, size, variant, removals, &rng);
+        if (made == 0)
+        {
+            fprintf(stderr, "Error: Not enough memory for a %dx%d puzzle.\n", size, size);
+            exit(1);
+        }
+        if (made < 0)
+        {
+            fprintf(stderr, "Error: Could not fill the grid of %dx%d %s puzzle %d within its search budget.\n",
+                size, size, variantName(variant), index + 1);
+            exit(1);
+        }
+        return;
+    }
+
+    int grid[N][N] = { 0 };
+    initShape(&book->shape, N, VARIANT_CLASSIC);
+    generateSudoku(grid, &rng);
+    memcpy(book->solution, grid, sizeof(grid));
+    book->removed = removeNumbers(grid, removals, &rng);
+    book->grade = gradePuzzle(grid, &book->effort);
+    memcpy(book->puzzle, grid, sizeof(grid));
+}
+
+void runBatchJob(BatchJob* job)
+{
+    for (int i = job->first; i < job->count; i += job->step)
+    {
+        makeBookPuzzle(&job->puzzles[i], job->size, job->variant, job->seed, i, job->removals);
+    }
+}
+
+#ifdef _WIN32
+DWORD WINAPI batchThread(LPVOID arg)
+{
+    runBatchJob((BatchJob*)arg);
+    return 0;
+}
+#else
+void* batchThread(void* arg)
+{
+    runBatchJob((BatchJob*)arg);
+    return NULL;
+}
+#endif
+
+int defaultThreadCount(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+#endif
+}
+
+// Makes every puzzle of the book. Worker t makes puzzles t, t + threads, ...
+// Nothing is shared but the output array, whose slots each belong to one
+// worker, so the workers never wait on each other. A worker whose thread
+// cannot be started is run on this thread afterwards; each puzzle has its
+// own seed, so the book comes out the same either way.
+void generateBook(BookPuzzle* puzzles, int count, uint64_t seed, int size, Variant variant, int removals, int threads)
+{
+    if (threads > count)
+    {
+        threads = count;
+    }
+    if (threads < 1)
+    {
+        threads = 1;
+    }
+
+    BatchJob* jobs = malloc(sizeof(BatchJob) * threads);
+    int* started = malloc(sizeof(int) * threads);
+#ifdef _WIN32
+    HANDLE* handles = malloc(sizeof(HANDLE) * threads);
+#else
+    pthread_t* handles = malloc(sizeof(pthread_t) * threads);
+#endif
+    if (jobs == NULL || started == NULL || handles == NULL)
+    {
+        BatchJob all = { puzzles, count, 0, 1, seed, size, variant, removals };
+        runBatchJob(&all);
+        free(handles);
+        free(started);
+        free(jobs);
+        return;
+    }
+
+    for (int t = 0; t < threads; t++)
+    {
+        BatchJob job = { puzzles, count, t, threads, seed, size, variant, removals };
+        jobs[t] = job;
+    }
+
+    // Worker 0 runs on this thread
+    int failed = 0;
+    for (int t = 1; t < threads; t++)
+    {
+#ifdef _WIN32
+        handles[t] = CreateThread(NULL, 0, batchThread, &jobs[t], 0, NULL);
+        started[t] = handles[t] != NULL;
+#else
+        started[t] = pthread_create(&handles[t], NULL, batchThread, &jobs[t]) == 0;
+#endif
+        failed += !started[t];
+    }
+    if (failed > 0)
+    {
+        fprintf(stderr, "Warning: %d of %d worker threads could not be started; their puzzles are made on the main thread.\n",
+            failed, threads - 1);
+    }
+    runBatchJob(&jobs[0]);
+    for (int t = 1; t < threads; t++)
+    {
+        if (!started[t])
+        {
+            runBatchJob(&jobs[t]);
+            continue;
+        }
+#ifdef _WIN32
+        WaitForSingleObject(handles[t], INFINITE);
+        CloseHandle(handles[t]);
+#else
+        pthread_join(handles[t], NULL);
+#endif
+    }
+
+    free(handles);
+    free(started);
+    free(jobs);
+}
+
+// --- BOOK LAYOUT ---
+// 9x9 puzzles go two across in 88-dot cells, solutions four across in
+// 40-dot cells; 4x4 grids twice as many across and 16x16 and 25x25 half as
+// many, in cells as large as fit. Every slot has its title above the grid.
+
+#define PUZZLE_CELL      88 // largest cells, dots
+#define SOLUTION_CELL    40
+#define DIGIT_DIVISOR    13 // font scale = cell / 13: 48-dot digits in 88-dot cells
+#define TITLE_SCALE      2
+#define SLOT_PADDING     24
+#define HEADER_HEIGHT    80
+
+// Blackens [x0, x1) x [y0, y1) of the band, clipped to it
+void fillRect(RasterBand* band, int x0, int y0, int x1, int y1)
+{
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > PAGE_WIDTH) x1 = PAGE_WIDTH;
+    if (y1 > band->height) y1 = band->height;
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return;
+    }
+
+    int first = x0 >> 3, last = (x1 - 1) >> 3;
+    unsigned char head = (unsigned char)(0xFF >> (x0 & 7));
+    unsigned char tail = (unsigned char)(0xFF << (7 - ((x1 - 1) & 7)));
+    for (int y = y0; y < y1; y++)
+    {
+        unsigned char* row = band->bits + (size_t)y * PAGE_STRIDE;
+        if (first == last)
+        {
+            row[first] |= head & tail;
+            continue;
+        }
+        row[first] |= head;
+        memset(row + first + 1, 0xFF, (size_t)(last - first - 1));
+        row[last] |= tail;
+    }
+}
+
+// font8x8_basic text with its top-left dot at (x, y), each font dot drawn
+// as a scale x scale square
+void drawText(RasterBand* band, int x, int y, const char* text, int scale)
+{
+    for (; *text != '\0'; text++, x += 8 * scale)
+    {
+        unsigned char c = (unsigned char)*text;
+        if (c > 127)
+        {
+            continue;
+        }
+
+        for (int row = 0; row < 8; row++)
+        {
+            unsigned char bits = font8x8_basic[c][row];
+            for (int col = 0; col < 8; col++)
+            {
+                if ((bits >> col) & 1) // bit 0 is the leftmost dot
+                {
+                    fillRect(band, x + col * scale, y + row * scale, x + (col + 1) * scale, y + (row + 1) * scale);
+                }
+            }
+        }
+    }
+}
+
+// Grid lines and digits with the top-left corner at (x, y). Box and
+// region borders are three times as thick as cell lines, and the cells of
+// X-sudoku diagonals are dotted.
+void drawPuzzle(RasterBand* band, int x, int y, int cellSize, int digitScale, const PuzzleShape* shape, const int* cells)
+{
+    int n = shape->size;
+    int thin = cellSize >= 60 ? 2 : 1;
+    int thick = 3 * thin;
+    int size = gridDots(n, cellSize);
+
+    for (int k = 0; k <= n; k++)
+    {
+        int width = k % n == 0 ? thick : thin;
+        int offset = k * cellSize + (thick - width) / 2;
+        fillRect(band, x + offset, y, x + offset + width, y + size);
+        fillRect(band, x, y + offset, x + size, y + offset + width);
+    }
+
+    // Borders between regions, one cell side at a time
+    for (int row = 0; row < n; row++)
+    {
+        for (int col = 0; col < n; col++)
+        {
+            int cell = row * n + col;
+            int left = x + col * cellSize;
+            int top = y + row * cellSize;
+            if (col + 1 < n && shape->region[cell] != shape->region[cell + 1])
+            {
+                fillRect(band, left + cellSize, top, left + cellSize + thick, top + cellSize + thick);
+            }
+            if (row + 1 < n && shape->region[cell] != shape->region[cell + n])
+            {
+                fillRect(band, left, top + cellSize, left + cellSize + thick, top + cellSize + thick);
+            }
+        }
+    }
+
+    if (shape->variant == VARIANT_X)
+    {
+        int step = 3 * thin + 1;
+        for (int i = 0; i < n; i++)
+        {
+            for (int pass = 0; pass < 2; pass++)
+            {
+                int left = x + (pass == 0 ? i : n - 1 - i) * cellSize + thick;
+                int top = y + i * cellSize + thick;
+                for (int dy = step / 2; dy < cellSize - thick; dy += step)
+                {
+                    for (int dx = step / 2; dx < cellSize - thick; dx += step)
+                    {
+                        fillRect(band, left + dx, top + dy, left + dx + thin, top + dy + thin);
+                    }
+                }
+            }
+        }
+    }
+
+    int digitSize = 8 * digitScale;
+    for (int row = 0; row < n; row++)
+    {
+        for (int col = 0; col < n; col++)
+        {
+            int digit = cells[row * n + col];
+            if (digit == UNASSIGNED)
+            {
+                continue;
+            }
+
+            char text[2] = { symbolFor(digit), '\0' };
+            drawText(band, x + col * cellSize + (cellSize + thick - digitSize) / 2,
+                y + row * cellSize + (cellSize + thick - digitSize) / 2, text, digitScale);
+        }
+    }
+}
+
+// Grids across the page, cell size and digit scale for a book of
+// size x size puzzles: the puzzles (pass 0) or the solutions (pass 1)
+void bookLayout(int size, int pass, int* across, int* cellSize, int* digitScale)
+{
+    int puzzlesAcross = size <= 4 ? 4 : size <= N ? 2 : 1;
+    int largest = pass == 0 ? PUZZLE_CELL : SOLUTION_CELL;
+
+    *across = pass == 0 ? puzzlesAcross : 2 * puzzlesAcross;
+    *cellSize = (PAGE_WIDTH / *across - 2 * SLOT_PADDING - 6) / size;
+    if (*cellSize > largest)
+    {
+        *cellSize = largest;
+    }
+    *digitScale = *cellSize / DIGIT_DIVISOR;
+}
+
+// Width and height of a drawn grid, outer lines included
+int gridDots(int size, int cellSize)
+{
+    return size * cellSize + 3 * (cellSize >= 60 ? 2 : 1);
+}
+
+int slotBandHeight(int size, int cellSize)
+{
+    return SLOT_PADDING + 8 * TITLE_SCALE + SLOT_PADDING / 2 + gridDots(size, cellSize) + SLOT_PADDING;
+}
+
+// Writes the band and clears it for the next one
+int writeBand(FILE* out, RasterBand* band)
+{
+    size_t size = (size_t)band->height * PAGE_STRIDE;
+    int ok = fwrite(band->bits, 1, size, out) == size;
+    memset(band->bits, 0, size);
+    return ok;
+}
+
+// Lays the book out and writes it top to bottom, one band at a time: a
+// title, rows of puzzles, then the solutions. Only one band is ever held.
+int writeBook(FILE* out, BookPuzzle* puzzles, int count, uint64_t seed, int pbm)
+{
+    const PuzzleShape* shape = &puzzles[0].shape;
+    int puzzlesAcross, puzzleCell, puzzleDigit;
+    int solutionsAcross, solutionCell, solutionDigit;
+    bookLayout(shape->size, 0, &puzzlesAcross, &puzzleCell, &puzzleDigit);
+    bookLayout(shape->size, 1, &solutionsAcross, &solutionCell, &solutionDigit);
+
+    int puzzleRows = (count + puzzlesAcross - 1) / puzzlesAcross;
+    int solutionRows = (count + solutionsAcross - 1) / solutionsAcross;
+    int puzzleHeight = slotBandHeight(shape->size, puzzleCell);
+    int solutionHeight = slotBandHeight(shape->size, solutionCell);
+
+    if (pbm)
+    {
+        int height = 2 * HEADER_HEIGHT + puzzleRows * puzzleHeight + solutionRows * solutionHeight;
+        fprintf(out, "P4\n%d %d\n", PAGE_WIDTH, height);
+    }
+
+    RasterBand band;
+    band.bits = calloc((size_t)puzzleHeight * PAGE_STRIDE, 1);
+    if (band.bits == NULL)
+    {
+        return 0;
+    }
+    int  ok = 1;
+    char text[96];
+
+    band.height = HEADER_HEIGHT;
+    if (shape->size == N && shape->variant == VARIANT_CLASSIC)
+    {
+        snprintf(text, sizeof(text), "SUDOKU  %d puzzles  seed %llu", count, (unsigned long long)seed);
+    }
+    else
+    {
+        snprintf(text, sizeof(text), "%s %dx%d  %d puzzles  seed %llu", variantName(shape->variant),
+            shape->size, shape->size, count, (unsigned long long)seed);
+        for (char* c = text; *c != '\0'; c++)
+        {
+            *c = (char)toupper((unsigned char)*c);
+        }
+    }
+    drawText(&band, (PAGE_WIDTH - (int)strlen(text) * 24) / 2, (HEADER_HEIGHT - 24) / 2, text, 3);
+    ok = ok && writeBand(out, &band);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        int across = pass == 0 ? puzzlesAcross : solutionsAcross;
+        int cellSize = pass == 0 ? puzzleCell : solutionCell;
+        int digitScale = pass == 0 ? puzzleDigit : solutionDigit;
+        int slotWidth = PAGE_WIDTH / across;
+        int gridSize = gridDots(shape->size, cellSize);
+
+        if (pass == 1)
+        {
+            band.height = HEADER_HEIGHT;
+            fillRect(&band, SLOT_PADDING, 0, PAGE_WIDTH - SLOT_PADDING, 4);
+            drawText(&band, (PAGE_WIDTH - 9 * 32) / 2, (HEADER_HEIGHT - 32) / 2 + 4, "SOLUTIONS", 4);
+            ok = ok && writeBand(out, &band);
+        }
+
+        band.height = pass == 0 ? puzzleHeight : solutionHeight;
+        for (int first = 0; first < count; first += across)
+        {
+            for (int i = first; i < first + across && i < count; i++)
+            {
+                int x = (i - first) * slotWidth + (slotWidth - gridSize) / 2;
+                if (pass == 0)
+                {
+                    snprintf(text, sizeof(text), "No. %d  %s", i + 1, gradeName(puzzles[i].grade));
+                }
+                else
+                {
+                    snprintf(text, sizeof(text), "No. %d", i + 1);
+                }
+                drawText(&band, x, SLOT_PADDING, text, TITLE_SCALE);
+                drawPuzzle(&band, x, SLOT_PADDING + 8 * TITLE_SCALE + SLOT_PADDING / 2, cellSize, digitScale,
+                    &puzzles[i].shape, pass == 0 ? puzzles[i].puzzle : puzzles[i].solution);
+            }
+            ok = ok && writeBand(out, &band);
+        }
+    }
+
+    free(band.bits);
+    return ok;
+}
+
+// Batch mode: makes the book on 'threads' workers, then prints it
+int runBatch(int count, uint64_t seed, int size, Variant variant, int removals, int threads, int pbm, const char* filename)
+{
+    BookPuzzle* puzzles = malloc(sizeof(BookPuzzle) * count);
+    if (puzzles == NULL)
+    {
+        fprintf(stderr, "Error: Not enough memory for %d puzzles.\n", count);
+        return 1;
+    }
+
+    struct timespec start, end;
+    timespec_get(&start, TIME_UTC);
+    generateBook(puzzles, count, seed, size, variant, removals, threads);
+    timespec_get(&end, TIME_UTC);
+    double ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1e6;
+
+    int grades[4] = { 0 };
+    int shortCount = 0;
+    for (int i = 0; i < count; i++)
+    {
+        grades[puzzles[i].grade]++;
+        if (puzzles[i].removed < removals)
+        {
+            shortCount++;
+        }
+    }
+    fprintf(stderr, "Generated %d puzzles in %.1f ms on %d thread(s): %d easy, %d medium, %d hard, %d expert.\n",
+        count, ms, threads, grades[GRADE_EASY], grades[GRADE_MEDIUM], grades[GRADE_HARD], grades[GRADE_EXPERT]);
+    if (shortCount > 0)
+    {
+        fprintf(stderr, "%d puzzle(s) kept more than %d digits to stay unique.\n", shortCount, size * size - removals);
+    }
+
+    FILE* out = stdout;
+    if (strcmp(filename, "-") != 0)
+    {
+        out = fopen(filename, "wb");
+        if (out == NULL)
+        {
+            fprintf(stderr, "Error: Could not create output file '%s'\n", filename);
+            free(puzzles);
+            return 1;
+        }
+    }
+#ifdef _WIN32
+    else
+    {
+        _setmode(_fileno(stdout), _O_BINARY);
+    }
+#endif
+
+    int ok = writeBook(out, puzzles, count, seed, pbm);
+    if (out != stdout)
+    {
+        ok = fclose(out) == 0 && ok;
+    }
+    free(puzzles);
+
+    if (!ok)
+    {
+        fprintf(stderr, "Error: Failed while writing '%s'\n", filename);
+        return 1;
+    }
+    fprintf(stderr, "Book saved to %s\n", filename);
+    return 0;
+}
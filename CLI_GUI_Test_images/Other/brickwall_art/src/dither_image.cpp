@@ -0,0 +1,124 @@
+// FILE: dither_image.cpp
+// PURPOSE: Dithers grayscale art, such as the brick wall designs in
+//          ../assets, to the 1-bit dots of the print head with the same
+//          threshold, bayer and floyd profiles the printer offers. The image
+//          is read, dithered and written a band of rows at a time, so a
+//          print of any length needs only a few bands of memory.
+//
+// AUTHOR: hamslices
+//
+// REQUIRES: lark_bitmap.h, lark_image_reader.h, lark_dither.h,
+//           lark_image_writer.h and lark_parallel.h in ../../common. Define
+//           LARK_HAVE_ZLIB and link zlib to read PNG art (and to compress PNG
+//           output).
+// USAGE: ./dither_image ../assets/elephant_org.png [--dither threshold|bayer|floyd]
+//            [--format pbm|png|pgm] [--output <file>] [--threads <n>] [--band-height <rows>]
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+
+#include "../../common/lark_bitmap.h"
+#include "../../common/lark_image_reader.h"
+#include "../../common/lark_dither.h"
+#include "../../common/lark_image_writer.h"
+#include "../../common/lark_parallel.h"
+
+// Output name for 'input' when none is given: the input's name without its
+// folder or extension, then the profile, e.g. elephant_org_floyd.pbm.
+std::string DefaultOutputName(const std::string& input, DitherMode mode, ImageFormat format) {
+    size_t slash = input.find_last_of("/\\");
+    std::string stem = slash == std::string::npos ? input : input.substr(slash + 1);
+    size_t dot = stem.find_last_of('.');
+    if (dot != std::string::npos && dot > 0) stem.erase(dot);
+    return stem + "_" + DitherModeName(mode) + "." + ImageFormatExtension(format);
+}
+
+int main(int argc, char* argv[]) {
+    const double DPI = 203.0;
+
+    std::string input, output;
+    DitherMode mode = DitherMode::Floyd;
+    ImageFormat format = ImageFormat::Pbm;
+    unsigned threads = 1;
+    int band_height = 256;
+    bool args_ok = true;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--dither" && i + 1 < argc) {
+            args_ok = ParseDitherMode(argv[++i], mode);
+        }
+        else if (arg == "--format" && i + 1 < argc) {
+            args_ok = ParseImageFormat(argv[++i], format);
+        }
+        else if (arg == "--output" && i + 1 < argc) {
+            output = argv[++i];
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            int n = std::atoi(argv[++i]);
+            threads = n > 0 ? static_cast<unsigned>(n) : DefaultThreadCount();
+        }
+        else if (arg == "--band-height" && i + 1 < argc) {
+            band_height = std::atoi(argv[++i]);
+        }
+        else if (input.empty() && arg.rfind("--", 0) != 0) {
+            input = arg;
+        }
+        else {
+            args_ok = false;
+        }
+    }
+    if (!args_ok || input.empty() || band_height < 1) {
+        std::cerr << "Usage: " << argv[0] << " <image.png|pgm|ppm|pbm> [--dither threshold|bayer|floyd]" << std::endl;
+        std::cerr << "           [--format pbm|png|pgm] [--output <file>] [--threads <n>] [--band-height <rows>]" << std::endl;
+        std::cerr << "  --dither       threshold: black below mid-gray, bayer: 8x8 ordered pattern," << std::endl;
+        std::cerr << "                 floyd: Floyd-Steinberg error diffusion (default)" << std::endl;
+        std::cerr << "  --format       pbm: packed 1 bit per dot (default), png: 1-bit PNG, pgm: 8-bit" << std::endl;
+        std::cerr << "  --output       Default: the image name with the profile, e.g. elephant_org_floyd.pbm" << std::endl;
+        std::cerr << "  --threads      Workers for floyd (0 = one per core; default 1); the dots do not" << std::endl;
+        std::cerr << "                 depend on it" << std::endl;
+        std::cerr << "  --band-height  Rows read, dithered and written at a time (default 256)" << std::endl;
+        return 1;
+    }
+    if (output.empty()) output = DefaultOutputName(input, mode, format);
+
+    ImageReader reader;
+    std::string error;
+    if (!reader.open(input, error)) {
+        std::cerr << "Error: " << error << std::endl;
+        return 1;
+    }
+    const int width = reader.width(), height = reader.height();
+
+    ImageWriter writer;
+    if (!writer.open(output, format, width, height)) {
+        std::cerr << "Error: Could not open file '" << output << "' for writing." << std::endl;
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Ditherer ditherer(mode, width, threads);
+    for (int top = 0; top < height; top += band_height) {
+        int rows = std::min(band_height, height - top);
+        GrayBitmap gray(width, rows, top);
+        MonoBitmap mono(width, rows, top);
+        if (!reader.readBand(gray)) {
+            std::cerr << "Error: '" << input << "' ends early or is corrupt." << std::endl;
+            return 1;
+        }
+        ditherer.ditherBand(gray, mono);
+        writer.writeBand(mono);
+    }
+    if (!writer.close()) {
+        std::cerr << "Error: Failed while writing '" << output << "'." << std::endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Dithered " << width << "x" << height << " (" << DitherModeName(mode) << ") to " << output << std::endl;
+    std::cerr << "Took " << seconds * 1000.0 << " ms, " << height / seconds / DPI << " in/s of paper at "
+        << DPI << " dpi" << std::endl;
+    return 0;
+}
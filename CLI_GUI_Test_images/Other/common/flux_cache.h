@@ -0,0 +1,243 @@
+// FILE: flux_cache.h
+// PURPOSE: A binary, columnar copy of a parsed fluxtable.csv (or .txt), so a
+//          plot can be redrawn without parsing the text again.
+//          csv_converter --cache writes it next to the table; solar_flux_plot
+//          maps it and copies the columns straight out of the mapping.
+//
+//          Layout, in the byte order of the machine that wrote it:
+//          - header: "LARKFLUX", format version, column count, row count,
+//            the size and modification time of the source file, and whether
+//            the Julian days are in order (so a date window can be found by
+//            binary search).
+//          - schema: for each column its name, the byte offset of its values
+//            and how many of them are missing (NaN).
+//          - columns: row count doubles each, every column starting on a
+//            64-byte boundary.
+//
+//          A row is kept when its Julian day and Carrington rotation parse.
+//          A flux field that is absent or not a number is stored as NaN, so
+//          a reader plotting only some of the columns still gets every row
+//          the CSV would have given it. A cache whose source size or time no
+//          longer matches is stale and should be ignored.
+//
+// AUTHOR: hamslices
+//
+// REQUIRES: flux_csv_reader.h and flux_fixed_reader.h in the same directory.
+// USAGE: FluxSourceStamp stamp;                     // writing
+//        ReadSourceStamp("fluxtable.csv", stamp);  // before reading the CSV
+//        FluxCacheColumns columns;
+//        double row[FLUX_CACHE_COLUMNS];
+//        if (ParseFluxCacheRow(line, format, row)) columns.append(row);
+//        WriteFluxCache(FluxCachePath("fluxtable.csv"), stamp, columns);
+//
+//        FluxCache cache;                           // reading
+//        if (cache.open(FluxCachePath("fluxtable.csv")) && cache.matches(stamp)) {
+//            const double* julian = cache.column(CACHE_JULIAN);
+//            ...
+//        }
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <system_error>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "flux_csv_reader.h"
+#include "flux_fixed_reader.h"
+
+// The columns of fluxtable.csv after the date and time, in file order
+enum FluxCacheColumn { CACHE_JULIAN, CACHE_CARRINGTON, CACHE_OBSERVED, CACHE_ADJUSTED, CACHE_URSI, FLUX_CACHE_COLUMNS };
+const char* const FLUX_CACHE_COLUMN_NAMES[FLUX_CACHE_COLUMNS] = { "julian", "carrington", "obsflux", "adjflux", "ursi" };
+
+const char FLUX_CACHE_MAGIC[8] = { 'L', 'A', 'R', 'K', 'F', 'L', 'U', 'X' };
+const uint32_t FLUX_CACHE_VERSION = 2;
+const uint64_t FLUX_CACHE_ALIGN = 64;
+
+struct FluxCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t columnCount;
+    uint64_t rowCount;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    uint32_t sorted;
+    uint32_t reserved;
+};
+
+struct FluxCacheSchemaEntry {
+    char name[16]; // zero padded
+    uint64_t offset;
+    uint64_t missing;
+};
+
+// The cache file for a source file: the same name with .fluxcache added.
+inline std::string FluxCachePath(const std::string& source) {
+    return source + ".fluxcache";
+}
+
+// Size and modification time of a source file. Take it before reading the
+// file: if the file changes in between, the cache comes out stale rather
+// than wrongly fresh.
+struct FluxSourceStamp { uint64_t size = 0; int64_t time = 0; };
+
+inline bool ReadSourceStamp(const std::string& path, FluxSourceStamp& stamp) {
+    std::error_code ec;
+    uintmax_t size = std::filesystem::file_size(path, ec);
+    if (ec) return false;
+    auto time = std::filesystem::last_write_time(path, ec);
+    if (ec) return false;
+    stamp.size = static_cast<uint64_t>(size);
+    stamp.time = static_cast<int64_t>(time.time_since_epoch().count());
+    return true;
+}
+
+// Parses one row into the cache columns. Returns false for the header and
+// for rows without a usable Julian day and Carrington rotation.
+inline bool ParseFluxCacheRow(std::string_view line, const FluxRowFormat& format, double* row) {
+    std::string_view fields[2 + FLUX_CACHE_COLUMNS];
+    size_t count = std::min<size_t>(format.split(line, fields, 2 + FLUX_CACHE_COLUMNS), 2 + FLUX_CACHE_COLUMNS);
+    if (count < 4) return false;
+    if (format.parse(fields[2], row[CACHE_JULIAN]) != std::errc() || format.parse(fields[3], row[CACHE_CARRINGTON]) != std::errc()) return false;
+    for (int c = CACHE_OBSERVED; c < FLUX_CACHE_COLUMNS; ++c) {
+        if (static_cast<size_t>(2 + c) >= count || format.parse(fields[2 + c], row[c]) != std::errc()) {
+            row[c] = std::numeric_limits<double>::quiet_NaN();
+        }
+    }
+    return true;
+}
+
+// The columns being gathered for a cache, a row at a time.
+struct FluxCacheColumns {
+    std::vector<double> values[FLUX_CACHE_COLUMNS];
+
+    size_t size() const { return values[0].size(); }
+
+    void append(const double* row) {
+        for (int c = 0; c < FLUX_CACHE_COLUMNS; ++c) values[c].push_back(row[c]);
+    }
+
+    void append(const FluxCacheColumns& more) {
+        for (int c = 0; c < FLUX_CACHE_COLUMNS; ++c) values[c].insert(values[c].end(), more.values[c].begin(), more.values[c].end());
+    }
+};
+
+// Writes the cache to a temporary name and renames it into place, so a
+// plot started meanwhile sees either the old cache or the whole new one.
+inline bool WriteFluxCache(const std::string& path, const FluxSourceStamp& stamp, const FluxCacheColumns& columns) {
+    const uint64_t rows = columns.size();
+    FluxCacheHeader header = {};
+    std::memcpy(header.magic, FLUX_CACHE_MAGIC, sizeof(header.magic));
+    header.version = FLUX_CACHE_VERSION;
+    header.columnCount = FLUX_CACHE_COLUMNS;
+    header.rowCount = rows;
+    header.sourceSize = stamp.size;
+    header.sourceTime = stamp.time;
+    const std::vector<double>& julian = columns.values[CACHE_JULIAN];
+    header.sorted = std::adjacent_find(julian.begin(), julian.end(), [](double a, double b) { return !(b >= a); }) == julian.end();
+
+    auto align = [](uint64_t offset) { return (offset + FLUX_CACHE_ALIGN - 1) / FLUX_CACHE_ALIGN * FLUX_CACHE_ALIGN; };
+    FluxCacheSchemaEntry schema[FLUX_CACHE_COLUMNS] = {};
+    uint64_t offset = align(sizeof(header) + sizeof(schema));
+    for (int c = 0; c < FLUX_CACHE_COLUMNS; ++c) {
+        std::strncpy(schema[c].name, FLUX_CACHE_COLUMN_NAMES[c], sizeof(schema[c].name) - 1);
+        schema[c].offset = offset;
+        schema[c].missing = static_cast<uint64_t>(std::count_if(columns.values[c].begin(), columns.values[c].end(), [](double v) { return std::isnan(v); }));
+        offset = align(offset + rows * sizeof(double));
+    }
+
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        static const char zeros[FLUX_CACHE_ALIGN] = {};
+        uint64_t written = 0;
+        auto put = [&](const void* data, uint64_t size) {
+            file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+            written += size;
+        };
+        put(&header, sizeof(header));
+        put(schema, sizeof(schema));
+        for (int c = 0; c < FLUX_CACHE_COLUMNS; ++c) {
+            put(zeros, schema[c].offset - written);
+            put(columns.values[c].data(), rows * sizeof(double));
+        }
+        if (!file.flush()) {
+            file.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temporary, path, ec);
+    if (ec) std::remove(temporary.c_str());
+    return !ec;
+}
+
+// A cache file mapped read-only; the columns point into the mapping.
+class FluxCache {
+public:
+    // False when the file is missing, from another version or byte order,
+    // lacks one of the columns or is cut short.
+    bool open(const std::string& path) {
+        close();
+        if (!file_.open(path) || file_.size() < sizeof(FluxCacheHeader)) return fail();
+        std::memcpy(&header_, file_.begin(), sizeof(header_));
+        if (std::memcmp(header_.magic, FLUX_CACHE_MAGIC, sizeof(header_.magic)) != 0 || header_.version != FLUX_CACHE_VERSION) return fail();
+        const uint64_t size = file_.size();
+        if (header_.columnCount > (size - sizeof(header_)) / sizeof(FluxCacheSchemaEntry)) return fail();
+        if (header_.rowCount > size / sizeof(double)) return fail();
+        const uint64_t bytes = header_.rowCount * sizeof(double);
+        for (uint32_t i = 0; i < header_.columnCount; ++i) {
+            FluxCacheSchemaEntry entry;
+            std::memcpy(&entry, file_.begin() + sizeof(header_) + i * sizeof(entry), sizeof(entry));
+            entry.name[sizeof(entry.name) - 1] = '\0';
+            for (int c = 0; c < FLUX_CACHE_COLUMNS; ++c) {
+                if (std::strcmp(entry.name, FLUX_CACHE_COLUMN_NAMES[c]) != 0) continue;
+                if (entry.offset % sizeof(double) != 0 || entry.offset > size || bytes > size - entry.offset) return fail();
+                columns_[c] = reinterpret_cast<const double*>(file_.begin() + entry.offset);
+                missing_[c] = static_cast<size_t>(entry.missing);
+            }
+        }
+        for (const double* column : columns_) {
+            if (!column) return fail();
+        }
+        return true;
+    }
+
+    void close() {
+        file_.close();
+        std::fill(std::begin(columns_), std::end(columns_), nullptr);
+        std::fill(std::begin(missing_), std::end(missing_), 0);
+        header_ = {};
+    }
+
+    // True when the cache was made from the source as it is now.
+    bool matches(const FluxSourceStamp& stamp) const {
+        return columns_[0] && header_.sourceSize == stamp.size && header_.sourceTime == stamp.time;
+    }
+
+    size_t rows() const { return static_cast<size_t>(header_.rowCount); }
+    bool sorted() const { return header_.sorted != 0; }
+    const double* column(FluxCacheColumn c) const { return columns_[c]; }
+    size_t missing(FluxCacheColumn c) const { return missing_[c]; }
+
+private:
+    bool fail() {
+        close();
+        return false;
+    }
+
+    MappedFile file_;
+    FluxCacheHeader header_ = {};
+    const double* columns_[FLUX_CACHE_COLUMNS] = {};
+    size_t missing_[FLUX_CACHE_COLUMNS] = {};
+};
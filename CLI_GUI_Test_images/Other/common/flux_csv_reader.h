@@ -0,0 +1,169 @@
+// FILE: flux_csv_reader.h
+// PURPOSE: Zero-copy CSV ingest for the solar flux tools. The file is memory
+//          mapped, lines and fields are handed out as std::string_view into
+//          the mapping, and numbers are parsed with std::from_chars. Nothing
+//          is allocated per row.
+//
+//          fluxtable.csv pads every field with trailing spaces
+//          ("02453307.229  "); fields are trimmed by narrowing the view, never
+//          by copying.
+//
+// AUTHOR: hamslices
+//
+// USAGE: MappedFile file;
+//        if (!file.open("fluxtable.csv")) { ... }
+//        CsvLineReader reader(file.begin(), file.end());
+//        std::string_view line, fields[7];
+//        reader.nextLine(line);                       // header
+//        while (reader.nextLine(line)) {
+//            if (SplitCsvFields(line, fields, 7) < 7) continue;
+//            double julian;
+//            if (ParseFieldDouble(fields[2], julian) == std::errc()) { ... }
+//        }
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <system_error>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only view of a whole file. An empty file opens successfully with size 0.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file_, &size)) { close(); return false; }
+        size_ = static_cast<size_t>(size.QuadPart);
+        if (size_ == 0) return true;
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping_) { close(); return false; }
+        data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+        if (!data_) { close(); return false; }
+#else
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) return false;
+        struct stat st;
+        if (fstat(fd_, &st) != 0) { close(); return false; }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ == 0) return true;
+        void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if (p == MAP_FAILED) { close(); return false; }
+        madvise(p, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(p);
+#endif
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (data_) munmap(const_cast<char*>(data_), size_);
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const char* begin() const { return data_; }
+    const char* end() const { return data_ + size_; }
+    size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
+
+// Hands out the lines of a buffer one at a time. The '\n' is dropped; a
+// trailing '\r' is left for field trimming to remove.
+class CsvLineReader {
+public:
+    CsvLineReader(const char* begin, const char* end) : pos_(begin), end_(end) {}
+
+    bool nextLine(std::string_view& line) {
+        if (pos_ >= end_) return false;
+        const char* nl = static_cast<const char*>(std::memchr(pos_, '\n', end_ - pos_));
+        const char* stop = nl ? nl : end_;
+        line = std::string_view(pos_, stop - pos_);
+        pos_ = nl ? nl + 1 : end_;
+        return true;
+    }
+
+    const char* position() const { return pos_; }
+
+private:
+    const char* pos_;
+    const char* end_;
+};
+
+inline bool IsFieldPadding(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+// Narrows a field past its padding, the same characters csv_converter trimmed.
+inline std::string_view TrimField(std::string_view field) {
+    size_t first = 0, last = field.size();
+    while (first < last && IsFieldPadding(field[first])) ++first;
+    while (last > first && IsFieldPadding(field[last - 1])) --last;
+    return field.substr(first, last - first);
+}
+
+// Splits a line on commas into trimmed views. Stores at most maxFields of
+// them and returns how many fields the line has in total.
+inline size_t SplitCsvFields(std::string_view line, std::string_view* fields, size_t maxFields) {
+    size_t count = 0;
+    size_t start = 0;
+    while (true) {
+        size_t comma = line.find(',', start);
+        size_t stop = comma == std::string_view::npos ? line.size() : comma;
+        if (count < maxFields) fields[count] = TrimField(line.substr(start, stop - start));
+        ++count;
+        if (comma == std::string_view::npos) break;
+        start = comma + 1;
+    }
+    return count;
+}
+
+// Parses the leading number of a field like std::stod does, ignoring any
+// padding around it. Returns std::errc() on success,
+// std::errc::invalid_argument when there is no number and
+// std::errc::result_out_of_range when it does not fit in a double.
+inline std::errc ParseFieldDouble(std::string_view field, double& value) {
+    field = TrimField(field);
+    const char* first = field.data();
+    const char* last = first + field.size();
+    if (first != last && *first == '+') ++first;
+    auto result = std::from_chars(first, last, value);
+    return result.ec;
+}
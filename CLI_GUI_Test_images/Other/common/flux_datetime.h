@@ -0,0 +1,161 @@
+// FILE: flux_datetime.h
+// PURPOSE: Allocation-free Julian Day / Carrington Rotation formatting for the
+//          solar flux tools. Dates and times are written straight into a
+//          caller-supplied char buffer as fixed-width text:
+//
+//              YYYY-MM-DD           10 chars  (FLUX_DATE_CHARS)
+//              HH:MM:SS              8 chars  (FLUX_TIME_CHARS)
+//              YYYY-MM-DD HH:MM:SS  19 chars  (FLUX_DATETIME_CHARS)
+//
+//          The calendar conversion is integer-only (Richards' day-number
+//          algorithm, Julian calendar before 1582-10-15 and Gregorian after,
+//          as the original Meeus-based julian_to_date did). Output matches
+//          the original stringstream functions exactly for years 0000-9999;
+//          flux_bench checks this. A day outside those years does not fit
+//          the fixed width and is written as ????-??-??, never as some other
+//          real date; flux_date_in_range lets a caller reject such rows
+//          first. parse_flux_date goes the other way, for dates typed on the
+//          command line.
+//
+// AUTHOR: hamslices
+//
+// USAGE: char buf[FLUX_DATETIME_CHARS];
+//        format_flux_datetime(julian, carrington, buf);
+//        out.append(buf, FLUX_DATETIME_CHARS);
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+const size_t FLUX_DATE_CHARS = 10;
+const size_t FLUX_TIME_CHARS = 8;
+const size_t FLUX_DATETIME_CHARS = 19;
+
+// First Julian Day number of the Gregorian calendar (1582-10-15)
+const long long GREGORIAN_START_JDN = 2299161;
+
+// Julian Day numbers of 0000-01-01 and 9999-12-31, the years YYYY can hold
+const long long FLUX_FIRST_JDN = 1721058;
+const long long FLUX_LAST_JDN = 5373484;
+
+// What format_julian_date writes for any other day (escaped: ??- is a trigraph)
+const char FLUX_UNKNOWN_DATE[] = "???\?-?\?-?\?";
+
+// True when format_julian_date can write the day as a real date. False for
+// NaN as well.
+inline bool flux_date_in_range(double julian_day) {
+    return julian_day + 0.5 >= static_cast<double>(FLUX_FIRST_JDN) && julian_day + 0.5 < static_cast<double>(FLUX_LAST_JDN + 1);
+}
+
+inline char* write_two_digits(int value, char* out) {
+    static const char digits[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    if (value < 0) value = 0;
+    if (value > 99) value = 99;
+    out[0] = digits[value * 2];
+    out[1] = digits[value * 2 + 1];
+    return out + 2;
+}
+
+// Writes the date (YYYY-MM-DD) of a Julian Day number, or ????-??-?? if it
+// is not in years 0000-9999. Returns out + 10.
+inline char* format_julian_date(double julian_day, char* out) {
+    if (!flux_date_in_range(julian_day)) {
+        for (size_t i = 0; i < FLUX_DATE_CHARS; ++i) *out++ = FLUX_UNKNOWN_DATE[i];
+        return out;
+    }
+    long long J = static_cast<long long>(julian_day + 0.5);
+    long long f = J + 1401;
+    if (J >= GREGORIAN_START_JDN) {
+        f += (((4 * J + 274277) / 146097) * 3) / 4 - 38;
+    }
+    long long e = 4 * f + 3;
+    long long h = 5 * ((e % 1461) / 4) + 2;
+    int day = static_cast<int>((h % 153) / 5 + 1);
+    int month = static_cast<int>((h / 153 + 2) % 12 + 1);
+    long long year = e / 1461 - 4716 + (12 + 2 - month) / 12;
+    out = write_two_digits(static_cast<int>(year / 100), out);
+    out = write_two_digits(static_cast<int>(year % 100), out);
+    *out++ = '-';
+    out = write_two_digits(month, out);
+    *out++ = '-';
+    return write_two_digits(day, out);
+}
+
+// Writes the fractional part of a Carrington Rotation (>= 0) as a time
+// (HH:MM:SS). The floating-point steps are the original's, so rounding is
+// identical. Returns out + 8.
+inline char* format_carrington_time(double carrington_rotation, char* out) {
+    double fraction = carrington_rotation - static_cast<long long>(carrington_rotation);
+    double total_seconds = fraction * 24.0 * 3600.0;
+    int hours = static_cast<int>(total_seconds / 3600);
+    total_seconds -= hours * 3600;
+    int minutes = static_cast<int>(total_seconds / 60);
+    int seconds = static_cast<int>(total_seconds - minutes * 60);
+    out = write_two_digits(hours, out);
+    *out++ = ':';
+    out = write_two_digits(minutes, out);
+    *out++ = ':';
+    return write_two_digits(seconds, out);
+}
+
+// Writes "YYYY-MM-DD HH:MM:SS". Returns out + 19.
+inline char* format_flux_datetime(double julian_day, double carrington_rotation, char* out) {
+    out = format_julian_date(julian_day, out);
+    *out++ = ' ';
+    return format_carrington_time(carrington_rotation, out);
+}
+
+// Batch form: formats count records back to back, FLUX_DATETIME_CHARS each,
+// into out (which must hold count * FLUX_DATETIME_CHARS chars).
+inline void format_flux_datetimes(const double* julian_days, const double* carrington_rotations, size_t count, char* out) {
+    for (size_t i = 0; i < count; ++i) {
+        out = format_flux_datetime(julian_days[i], carrington_rotations[i], out);
+    }
+}
+
+// Reads "YYYY-MM-DD" into the Julian Day number of that date, the inverse of
+// format_julian_date (which gives the date of JDN for Julian days JDN - 0.5
+// up to JDN + 0.5). Returns false for anything else, or a day the calendar
+// does not have.
+inline bool parse_flux_date(std::string_view text, long long& jdn) {
+    if (text.size() != FLUX_DATE_CHARS || text[4] != '-' || text[7] != '-') return false;
+    int digits[8];
+    const int at[8] = { 0, 1, 2, 3, 5, 6, 8, 9 };
+    for (int i = 0; i < 8; ++i) {
+        if (text[at[i]] < '0' || text[at[i]] > '9') return false;
+        digits[i] = text[at[i]] - '0';
+    }
+    long long year = digits[0] * 1000 + digits[1] * 100 + digits[2] * 10 + digits[3];
+    int month = digits[4] * 10 + digits[5];
+    int day = digits[6] * 10 + digits[7];
+    if (month < 1 || month > 12 || day < 1) return false;
+    // Day numbers counted from March, so the leap day ends the year
+    long long a = (14 - month) / 12;
+    long long y = year + 4800 - a;
+    long long m = month + 12 * a - 3;
+    long long days = day + (153 * m + 2) / 5 + 365 * y + y / 4;
+    jdn = days + y / 400 - y / 100 - 32045;
+    if (jdn < GREGORIAN_START_JDN) jdn = days - 32083;
+    // Round trip, which rejects 02-30, 1582-10-10 and the like
+    char check[FLUX_DATE_CHARS];
+    format_julian_date(static_cast<double>(jdn), check);
+    return text == std::string_view(check, FLUX_DATE_CHARS);
+}
+
+// String conveniences for labels and other places that are not hot.
+inline std::string julian_to_date(double julian_day) {
+    char buf[FLUX_DATE_CHARS];
+    format_julian_date(julian_day, buf);
+    return std::string(buf, FLUX_DATE_CHARS);
+}
+
+inline std::string carrington_to_time(double carrington_rotation) {
+    char buf[FLUX_TIME_CHARS];
+    format_carrington_time(carrington_rotation, buf);
+    return std::string(buf, FLUX_TIME_CHARS);
+}
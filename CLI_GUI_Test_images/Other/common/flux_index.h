@@ -0,0 +1,162 @@
+// FILE: flux_index.h
+// PURPOSE: A sparse index of a fluxtable.csv (or .txt): the Julian day and
+//          byte offset of every FLUX_INDEX_STRIDE-th row. fluxjulian grows
+//          down the file, so the rows of a date window are found by a binary
+//          search over the index and a short scan, and a month of a 20-year
+//          archive parses only that month.
+//
+//          The index is built on first use and kept next to the table as
+//          <file>.fluxindex, stamped with the source size and modification
+//          time like flux_cache.h, and rebuilt when they no longer match.
+//          The build checks every row; if the file is not in time order the
+//          index says so, and a query falls back to reading the whole file.
+//
+// AUTHOR: hamslices
+//
+// REQUIRES: flux_csv_reader.h, flux_fixed_reader.h and flux_cache.h in the
+//           same directory.
+// USAGE: FluxIndex index;
+//        if (!index.load(FluxIndexPath(csv), stamp)) {
+//            index.build(file.begin(), file.end(), stamp);
+//            index.save(FluxIndexPath(csv));
+//        }
+//        CsvLineReader reader(file.begin() + index.seek(fromJulian), file.end());
+//        // parse rows; once one is later than the window, stop if index.sorted()
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <system_error>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "flux_csv_reader.h"
+#include "flux_fixed_reader.h"
+#include "flux_cache.h"
+
+const uint32_t FLUX_INDEX_STRIDE = 1024;
+const char FLUX_INDEX_MAGIC[8] = { 'L', 'A', 'R', 'K', 'F', 'I', 'D', 'X' };
+const uint32_t FLUX_INDEX_VERSION = 1;
+
+struct FluxIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t stride;
+    uint64_t count;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+    uint64_t dataOffset; // first row after the header
+    uint32_t sorted;
+    uint32_t reserved;
+};
+
+struct FluxIndexEntry { double julian; uint64_t offset; };
+
+// The index file for a source file: the same name with .fluxindex added.
+inline std::string FluxIndexPath(const std::string& source) {
+    return source + ".fluxindex";
+}
+
+class FluxIndex {
+public:
+    // Indexes the mapped file [begin, end), skipping its header (and the
+    // dashes of a fixed-width file) as the plotter does. Only rows whose
+    // Julian day parses are counted.
+    void build(const char* begin, const char* end, const FluxSourceStamp& stamp, uint32_t stride = FLUX_INDEX_STRIDE) {
+        entries_.clear();
+        header_ = {};
+        header_.stride = stride;
+        header_.sourceSize = stamp.size;
+        header_.sourceTime = stamp.time;
+        header_.sorted = 1;
+        const char* data;
+        FluxRowFormat format = DetectFluxRowFormat(begin, end, data);
+        header_.dataOffset = static_cast<uint64_t>(data - begin);
+        CsvLineReader reader(data, end);
+        std::string_view line, fields[3];
+        uint64_t rows = 0;
+        double previous = 0.0;
+        while (reader.nextLine(line)) {
+            double julian;
+            if (format.split(line, fields, 3) < 3 || format.parse(fields[2], julian) != std::errc()) continue;
+            if (rows > 0 && !(julian >= previous)) header_.sorted = 0;
+            if (rows % stride == 0) entries_.push_back({ julian, static_cast<uint64_t>(line.data() - begin) });
+            previous = julian;
+            ++rows;
+        }
+        header_.count = entries_.size();
+    }
+
+    // False when the file is missing, corrupt or was made from another
+    // version of the source.
+    bool load(const std::string& path, const FluxSourceStamp& stamp) {
+        entries_.clear();
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+        if (!file.read(reinterpret_cast<char*>(&header_), sizeof(header_))) return fail();
+        if (std::memcmp(header_.magic, FLUX_INDEX_MAGIC, sizeof(header_.magic)) != 0 || header_.version != FLUX_INDEX_VERSION) return fail();
+        if (header_.sourceSize != stamp.size || header_.sourceTime != stamp.time || header_.dataOffset > stamp.size) return fail();
+        std::error_code ec;
+        uintmax_t size = std::filesystem::file_size(path, ec);
+        if (ec || header_.count != (size - sizeof(header_)) / sizeof(FluxIndexEntry)) return fail();
+        entries_.resize(static_cast<size_t>(header_.count));
+        if (!file.read(reinterpret_cast<char*>(entries_.data()), static_cast<std::streamsize>(entries_.size() * sizeof(FluxIndexEntry)))) return fail();
+        for (const FluxIndexEntry& entry : entries_) {
+            if (entry.offset < header_.dataOffset || entry.offset >= stamp.size) return fail();
+        }
+        return true;
+    }
+
+    // Written under a temporary name and renamed into place, like the cache.
+    bool save(const std::string& path) const {
+        FluxIndexHeader header = header_;
+        std::memcpy(header.magic, FLUX_INDEX_MAGIC, sizeof(header.magic));
+        header.version = FLUX_INDEX_VERSION;
+        const std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!file) return false;
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(entries_.data()), static_cast<std::streamsize>(entries_.size() * sizeof(FluxIndexEntry)));
+            if (!file.flush()) {
+                file.close();
+                std::remove(temporary.c_str());
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(temporary, path, ec);
+        if (ec) std::remove(temporary.c_str());
+        return !ec;
+    }
+
+    // Byte offset to start reading at so that no row with a Julian day of
+    // 'julian' or later is missed: the last indexed row before it.
+    uint64_t seek(double julian) const {
+        if (!header_.sorted || entries_.empty()) return header_.dataOffset;
+        auto later = std::lower_bound(entries_.begin(), entries_.end(), julian,
+            [](const FluxIndexEntry& entry, double value) { return entry.julian < value; });
+        if (later == entries_.begin()) return header_.dataOffset;
+        return (later - 1)->offset;
+    }
+
+    // True when every row is in time order, so a scan may stop at the first
+    // row past the window.
+    bool sorted() const { return header_.sorted != 0; }
+    size_t size() const { return entries_.size(); }
+
+private:
+    bool fail() {
+        entries_.clear();
+        header_ = {};
+        return false;
+    }
+
+    FluxIndexHeader header_ = {};
+    std::vector<FluxIndexEntry> entries_;
+};
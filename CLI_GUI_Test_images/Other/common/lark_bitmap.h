@@ -0,0 +1,82 @@
+// FILE: lark_bitmap.h
+// PURPOSE: Raster targets shared by the sample generators.
+//          GrayBitmap keeps one byte per pixel (PGM rows). MonoBitmap packs
+//          eight pixels per byte, MSB first, 1 = black, which is both the PBM
+//          (P4) row layout and the 216-byte row the 1728-dot print head takes.
+//
+//          Either bitmap can stand for a horizontal band of a taller canvas:
+//          coordinates are always canvas coordinates and 'top' is the first
+//          canvas row the bitmap holds.
+//
+// AUTHOR: hamslices
+//
+// USAGE: #include "lark_bitmap.h"
+
+#pragma once
+
+#include <vector>
+#include <cstring>
+
+struct GrayBitmap {
+    int width = 0;
+    int top = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels;
+
+    GrayBitmap() = default;
+    GrayBitmap(int w, int h, int firstRow = 0) : width(w), top(firstRow), height(h), pixels(static_cast<size_t>(w) * h, 255) {}
+
+    int Stride() const { return width; }
+    bool IntersectsRows(int y0, int y1) const { return y1 >= top && y0 < top + height; }
+    bool Contains(int x, int y) const { return x >= 0 && x < width && y >= top && y < top + height; }
+    unsigned char* Row(int y) { return &pixels[static_cast<size_t>(y - top) * width]; }
+    const unsigned char* Row(int y) const { return &pixels[static_cast<size_t>(y - top) * width]; }
+
+    void Clear(unsigned char color) { std::memset(pixels.data(), color, pixels.size()); }
+    // Callers clip first; x and y must be inside the bitmap.
+    void Set(int x, int y, unsigned char color) { Row(y)[x] = color; }
+    // Dots [x0, x1) of row y, clipped by the caller like Set.
+    void FillSpan(int x0, int x1, int y, unsigned char color) {
+        if (x1 > x0) std::memset(Row(y) + x0, color, static_cast<size_t>(x1 - x0));
+    }
+    bool IsBlack(int x, int y) const { return Row(y)[x] < 128; }
+};
+
+struct MonoBitmap {
+    int width = 0;
+    int top = 0;
+    int height = 0;
+    std::vector<unsigned char> bits;
+
+    MonoBitmap() = default;
+    MonoBitmap(int w, int h, int firstRow = 0) : width(w), top(firstRow), height(h), bits(static_cast<size_t>((w + 7) / 8) * h, 0) {}
+
+    int Stride() const { return (width + 7) / 8; }
+    bool IntersectsRows(int y0, int y1) const { return y1 >= top && y0 < top + height; }
+    bool Contains(int x, int y) const { return x >= 0 && x < width && y >= top && y < top + height; }
+    unsigned char* Row(int y) { return &bits[static_cast<size_t>(y - top) * Stride()]; }
+    const unsigned char* Row(int y) const { return &bits[static_cast<size_t>(y - top) * Stride()]; }
+
+    // Gray levels below 128 print as black, everything else as paper.
+    void Clear(unsigned char color) { std::memset(bits.data(), color < 128 ? 0xFF : 0x00, bits.size()); }
+    void Set(int x, int y, unsigned char color) {
+        unsigned char mask = static_cast<unsigned char>(0x80 >> (x & 7));
+        unsigned char& byte = Row(y)[x >> 3];
+        byte = color < 128 ? (byte | mask) : (byte & ~mask);
+    }
+    // Whole bytes in the middle of the span are memset.
+    void FillSpan(int x0, int x1, int y, unsigned char color) {
+        if (x1 <= x0) return;
+        unsigned char* row = Row(y);
+        bool black = color < 128;
+        int first = x0 >> 3, last = (x1 - 1) >> 3;
+        unsigned char head = static_cast<unsigned char>(0xFF >> (x0 & 7));
+        unsigned char tail = static_cast<unsigned char>(0xFF << (7 - ((x1 - 1) & 7)));
+        if (first == last) head &= tail;
+        row[first] = black ? (row[first] | head) : (row[first] & ~head);
+        if (first == last) return;
+        if (last > first + 1) std::memset(row + first + 1, black ? 0xFF : 0x00, static_cast<size_t>(last - first - 1));
+        row[last] = black ? (row[last] | tail) : (row[last] & ~tail);
+    }
+    bool IsBlack(int x, int y) const { return (Row(y)[x >> 3] >> (7 - (x & 7))) & 1; }
+};
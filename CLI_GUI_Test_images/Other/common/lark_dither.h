@@ -0,0 +1,262 @@
+// FILE: lark_dither.h
+// PURPOSE: Turns 8-bit gray rows into 1-bit print rows (the MonoBitmap / PBM
+//          layout) one row at a time, so art of any length streams through
+//          in bands. The three profiles match the printer's --dither option:
+//          - threshold: black below 128.
+//          - bayer: an 8x8 ordered dither.
+//          - floyd: Floyd-Steinberg error diffusion, left to right on every
+//            row, in integer sixteenths so any split of the work gives the
+//            same dots.
+//
+//          Threshold and Bayer compare 16 dots per SSE2 instruction where
+//          the compiler targets it, with a scalar loop elsewhere.
+//
+//          Floyd keeps only the error rows it needs: one incoming and one
+//          outgoing row per row in flight. With more than one thread a band
+//          is dithered as a wavefront: each thread takes every n-th row and
+//          follows the row above it along the page, a segment at a time.
+//          A dot only needs the three dots above it, so a row can run one
+//          segment plus two dots behind the row above; the result is the
+//          same as with one thread.
+//
+// AUTHOR: hamslices
+//
+// REQUIRES: lark_bitmap.h in the same directory.
+// USAGE: Ditherer ditherer(DitherMode::Floyd, width, threads);
+//        ditherer.ditherBand(grayBand, monoBand);   // top to bottom, same rows
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <system_error>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LARK_DITHER_SSE2 1
+#endif
+
+#include "lark_bitmap.h"
+
+enum class DitherMode { Threshold, Bayer, Floyd };
+
+inline bool ParseDitherMode(const std::string& name, DitherMode& mode) {
+    if (name == "threshold") { mode = DitherMode::Threshold; return true; }
+    if (name == "bayer") { mode = DitherMode::Bayer; return true; }
+    if (name == "floyd") { mode = DitherMode::Floyd; return true; }
+    return false;
+}
+
+inline const char* DitherModeName(DitherMode mode) {
+    switch (mode) {
+    case DitherMode::Threshold: return "threshold";
+    case DitherMode::Bayer: return "bayer";
+    default: return "floyd";
+    }
+}
+
+// Dots darker than this print black under the threshold profile, as in
+// MonoBitmap::Set
+const unsigned char DITHER_THRESHOLD = 128;
+
+// Classic recursive 8x8 Bayer index matrix. A dot prints black when its
+// gray level is below 4 * index + 2, so 0 is all black and 255 all paper.
+const unsigned char BAYER_8X8[8][8] = {
+    {  0, 32,  8, 40,  2, 34, 10, 42 },
+    { 48, 16, 56, 24, 50, 18, 58, 26 },
+    { 12, 44,  4, 36, 14, 46,  6, 38 },
+    { 60, 28, 52, 20, 62, 30, 54, 22 },
+    {  3, 35, 11, 43,  1, 33,  9, 41 },
+    { 51, 19, 59, 27, 49, 17, 57, 25 },
+    { 15, 47,  7, 39, 13, 45,  5, 37 },
+    { 63, 31, 55, 23, 61, 29, 53, 21 },
+};
+
+inline unsigned char BayerLevel(int x, int y) {
+    return static_cast<unsigned char>(4 * BAYER_8X8[y & 7][x & 7] + 2);
+}
+
+// Packs one row: dot x is black when gray[x] < levels[x & 15]. 'bits' gets
+// (width + 7) / 8 bytes; the padding bits of the last byte are paper.
+inline void PackBelow(const unsigned char* gray, int width, const unsigned char levels[16], unsigned char* bits) {
+    int x = 0;
+#ifdef LARK_DITHER_SSE2
+    // SSE2 only compares signed bytes, so both sides are shifted by 128.
+    // movemask puts dot 0 in bit 0, and a print row wants it in bit 7.
+    const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80));
+    const __m128i level = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(levels)), bias);
+    for (; x + 16 <= width; x += 16) {
+        __m128i v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(gray + x)), bias);
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmplt_epi8(v, level)));
+        for (int half = 0; half < 2; ++half) {
+            unsigned b = (mask >> (8 * half)) & 0xFF;
+            b = ((b & 0xF0) >> 4) | ((b & 0x0F) << 4);
+            b = ((b & 0xCC) >> 2) | ((b & 0x33) << 2);
+            b = ((b & 0xAA) >> 1) | ((b & 0x55) << 1);
+            bits[(x >> 3) + half] = static_cast<unsigned char>(b);
+        }
+    }
+#endif
+    for (; x < width; x += 8) {
+        unsigned char byte = 0;
+        for (int dot = 0; dot < 8 && x + dot < width; ++dot) {
+            if (gray[x + dot] < levels[(x + dot) & 15]) byte |= static_cast<unsigned char>(0x80 >> dot);
+        }
+        bits[x >> 3] = byte;
+    }
+}
+
+inline void DitherThresholdRow(const unsigned char* gray, int width, unsigned char* bits) {
+    unsigned char levels[16];
+    std::memset(levels, DITHER_THRESHOLD, sizeof(levels));
+    PackBelow(gray, width, levels, bits);
+}
+
+// 'y' is the canvas row, which picks the row of the matrix
+inline void DitherBayerRow(const unsigned char* gray, int width, int y, unsigned char* bits) {
+    unsigned char levels[16];
+    for (int x = 0; x < 16; ++x) levels[x] = BayerLevel(x, y);
+    PackBelow(gray, width, levels, bits);
+}
+
+// Floyd-Steinberg over rows of a fixed width. Errors are kept in sixteenths
+// of a gray level: a dot passes 7/16 of its error right, 3/16 down-left,
+// 5/16 down and 1/16 down-right.
+class FloydDitherer {
+public:
+    // Segment of a row one thread dithers before telling the row below
+    static const int SEGMENT = 64;
+
+    explicit FloydDitherer(int width, unsigned threads = 1) : width_(width), threads_(std::max(1u, threads)) {
+        // Row y reads errors[y % n] and writes errors[(y + 1) % n]; with a
+        // thread per row in flight, n = threads + 1 keeps a buffer from
+        // being reused before the row that reads it is done.
+        errors_.assign(threads_ + 1, std::vector<int>(static_cast<size_t>(width_) + 2, 0));
+    }
+
+    // Dithers the rows of 'gray' into the same rows of 'mono'. Bands must
+    // come in order, top to bottom, as the error carries across them.
+    void ditherBand(const GrayBitmap& gray, MonoBitmap& mono) {
+        const int first = gray.top, last = gray.top + gray.height;
+        if (threads_ == 1 || gray.height < 2) {
+            ditherRows(gray, mono, first, last);
+            return;
+        }
+
+        // done[i] counts the dots finished on row first + i - 1; the row
+        // above the band is complete
+        std::unique_ptr<std::atomic<int>[]> done(new std::atomic<int>[gray.height + 1]);
+        done[0].store(width_, std::memory_order_relaxed);
+        for (int i = 1; i <= gray.height; ++i) done[i].store(0, std::memory_order_relaxed);
+        std::atomic<bool> abandon(false);
+
+        auto worker = [&](unsigned t) {
+            for (int y = first + static_cast<int>(t); y < last; y += static_cast<int>(threads_)) {
+                std::atomic<int>& above = done[y - first];
+                std::atomic<int>& mine = done[y - first + 1];
+                int carry = 0;
+                for (int x0 = 0; x0 < width_; x0 += SEGMENT) {
+                    int x1 = std::min(x0 + SEGMENT, width_);
+                    // Dot x needs the errors of dots x - 1 .. x + 1 above
+                    int need = std::min(x1 + 1, width_);
+                    while (above.load(std::memory_order_acquire) < need) {
+                        if (abandon.load(std::memory_order_relaxed)) return;
+                        std::this_thread::yield();
+                    }
+                    ditherSpan(gray, mono, y, x0, x1, carry);
+                    mine.store(x1, std::memory_order_release);
+                }
+                finishRow(y);
+            }
+        };
+        std::vector<std::thread> pool;
+        try {
+            for (unsigned t = 1; t < threads_; ++t) pool.emplace_back(worker, t);
+        }
+        catch (const std::system_error&) {
+            // The rows of a worker that never started would hold up every
+            // row below them. No worker has dithered a dot yet: all of them
+            // wait, through the rows above, on the first row, which is this
+            // thread's. So stop them and do the band here.
+            abandon.store(true, std::memory_order_relaxed);
+            for (auto& t : pool) t.join();
+            ditherRows(gray, mono, first, last);
+            return;
+        }
+        worker(0);
+        for (auto& t : pool) t.join();
+    }
+
+private:
+    // Rows [first, last) one after another, on this thread
+    void ditherRows(const GrayBitmap& gray, MonoBitmap& mono, int first, int last) {
+        for (int y = first; y < last; ++y) {
+            int carry = 0;
+            ditherSpan(gray, mono, y, 0, width_, carry);
+            finishRow(y);
+        }
+    }
+
+    // Dots [x0, x1) of row y. x0 must be a multiple of 8 so that each
+    // output byte belongs to one span.
+    void ditherSpan(const GrayBitmap& gray, MonoBitmap& mono, int y, int x0, int x1, int& carry) {
+        const unsigned char* src = gray.Row(y);
+        unsigned char* dst = mono.Row(y);
+        int* in = errors_[y % errors_.size()].data() + 1;        // this row, from the row above
+        int* out = errors_[(y + 1) % errors_.size()].data() + 1; // the row below
+        for (int x = x0; x < x1; x += 8) {
+            unsigned char byte = 0;
+            for (int dot = 0; dot < 8 && x + dot < x1; ++dot) {
+                int i = x + dot;
+                int value = src[i] + ((in[i] + carry + 8) >> 4);
+                in[i] = 0;
+                bool black = value < 128;
+                int error = value - (black ? 0 : 255);
+                if (black) byte |= static_cast<unsigned char>(0x80 >> dot);
+                carry = 7 * error;
+                out[i - 1] += 3 * error;
+                out[i] += 5 * error;
+                out[i + 1] += error;
+            }
+            dst[x >> 3] = byte;
+        }
+    }
+
+    // The error pushed past either edge of row y lands in the padding
+    // slots of the row below, which nothing reads; clear them.
+    void finishRow(int y) {
+        std::vector<int>& in = errors_[y % errors_.size()];
+        in.front() = 0;
+        in.back() = 0;
+    }
+
+    int width_;
+    unsigned threads_;
+    std::vector<std::vector<int>> errors_; // width + 2 each: a padding slot on both sides
+};
+
+// One profile for a whole image, fed a band at a time.
+class Ditherer {
+public:
+    Ditherer(DitherMode mode, int width, unsigned threads = 1) : mode_(mode), floyd_(width, mode == DitherMode::Floyd ? threads : 1) {}
+
+    void ditherBand(const GrayBitmap& gray, MonoBitmap& mono) {
+        if (mode_ == DitherMode::Floyd) {
+            floyd_.ditherBand(gray, mono);
+            return;
+        }
+        for (int y = gray.top; y < gray.top + gray.height; ++y) {
+            if (mode_ == DitherMode::Bayer) DitherBayerRow(gray.Row(y), gray.width, y, mono.Row(y));
+            else DitherThresholdRow(gray.Row(y), gray.width, mono.Row(y));
+        }
+    }
+
+private:
+    DitherMode mode_;
+    FloydDitherer floyd_;
+};
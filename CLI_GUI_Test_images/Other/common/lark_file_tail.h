@@ -0,0 +1,126 @@
+// FILE: lark_file_tail.h
+// PURPOSE: Follows a file that another program keeps appending to, the way
+//          `tail -f` does. Only the bytes added since the last read are
+//          loaded, and only whole lines are handed out; a half-written last
+//          line waits for its newline.
+//
+//          On Linux the wait blocks on inotify so new rows are picked up as
+//          soon as they land; elsewhere it simply sleeps for the poll interval.
+//
+// AUTHOR: hamslices
+//
+// USAGE: FileTail tail;
+//        tail.open("fluxtable.csv");
+//        while (running) {
+//            std::string lines;
+//            bool restarted;
+//            if (tail.read(lines, restarted) && !lines.empty()) { ... }
+//            else tail.wait(1000);
+//        }
+
+#pragma once
+
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <thread>
+#include <chrono>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+class FileTail {
+public:
+    FileTail() = default;
+    FileTail(const FileTail&) = delete;
+    FileTail& operator=(const FileTail&) = delete;
+    ~FileTail() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+        path_ = path;
+        offset_ = 0;
+        partial_.clear();
+        std::error_code ec;
+        if (!std::filesystem::exists(path_, ec)) return false;
+#ifdef __linux__
+        notify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (notify_ >= 0 && inotify_add_watch(notify_, path_.c_str(), IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF) < 0) {
+            ::close(notify_);
+            notify_ = -1; // fall back to sleeping
+        }
+#endif
+        return true;
+    }
+
+    void close() {
+#ifdef __linux__
+        if (notify_ >= 0) ::close(notify_);
+        notify_ = -1;
+#endif
+    }
+
+    // Appends the complete lines written since the last call to 'lines'.
+    // If the file shrank (truncated or replaced) the tail starts over from
+    // the top and 'restarted' is set. Returns false if the file can't be read.
+    bool read(std::string& lines, bool& restarted) {
+        restarted = false;
+        std::error_code ec;
+        uintmax_t size = std::filesystem::file_size(path_, ec);
+        if (ec) return false;
+        if (size < offset_) {
+            offset_ = 0;
+            partial_.clear();
+            restarted = true;
+        }
+        if (size == offset_) return true;
+        std::ifstream file(path_, std::ios::in | std::ios::binary);
+        if (!file) return false;
+        file.seekg(static_cast<std::streamoff>(offset_));
+        size_t fresh = static_cast<size_t>(size - offset_);
+        size_t kept = partial_.size();
+        partial_.resize(kept + fresh);
+        file.read(&partial_[kept], static_cast<std::streamsize>(fresh));
+        partial_.resize(kept + static_cast<size_t>(file.gcount()));
+        offset_ += static_cast<uintmax_t>(file.gcount());
+        size_t lastNewline = partial_.rfind('\n');
+        if (lastNewline != std::string::npos) {
+            lines.append(partial_, 0, lastNewline + 1);
+            partial_.erase(0, lastNewline + 1);
+        }
+        return true;
+    }
+
+    // Hands over an unterminated last line, for when the writer is known to
+    // be finished with it.
+    void takePartial(std::string& lines) {
+        lines += partial_;
+        partial_.clear();
+    }
+
+    // Blocks until the file may have changed or timeoutMs has passed.
+    void wait(int timeoutMs) {
+#ifdef __linux__
+        if (notify_ >= 0) {
+            pollfd pfd{ notify_, POLLIN, 0 };
+            if (poll(&pfd, 1, timeoutMs) > 0) {
+                char events[4096];
+                while (::read(notify_, events, sizeof(events)) > 0) {} // drain
+            }
+            return;
+        }
+#endif
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+    }
+
+private:
+    std::string path_;
+    uintmax_t offset_ = 0;
+    std::string partial_;
+#ifdef __linux__
+    int notify_ = -1;
+#endif
+};
@@ -0,0 +1,356 @@
+// FILE: lark_image_reader.h
+// PURPOSE: Streams an image in as 8-bit gray rows, a band at a time, so art
+//          of any length can be dithered without ever holding all of it.
+//
+//          Reads binary PGM (P5), PPM (P6) and PBM (P4), and PNG: gray,
+//          palette, RGB, with or without alpha, any bit depth, not
+//          interlaced. Color is reduced to Rec. 601 luma; transparent
+//          areas are composited onto white paper. PNG input needs zlib:
+//          compile with -DLARK_HAVE_ZLIB and link -lz, the same switch as
+//          PNG output in lark_image_writer.h.
+//
+// AUTHOR: hamslices
+//
+// REQUIRES: lark_bitmap.h in the same directory.
+// USAGE: ImageReader reader;
+//        if (!reader.open("art.png", error)) ...
+//        GrayBitmap band(reader.width(), 256, 0);
+//        reader.readBand(band);   // top to bottom, band.height rows at a time
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+
+#ifdef LARK_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "lark_bitmap.h"
+
+class ImageReader {
+public:
+    ~ImageReader() { close(); }
+
+    // Reads the header. On failure 'error' says why.
+    bool open(const std::string& filename, std::string& error) {
+        close();
+        file_.open(filename, std::ios::in | std::ios::binary);
+        if (!file_) {
+            error = "Cannot open '" + filename + "'";
+            return false;
+        }
+        rowsRead_ = 0;
+        unsigned char magic[8] = {};
+        file_.read(reinterpret_cast<char*>(magic), 2);
+        if (magic[0] == 'P' && (magic[1] == '4' || magic[1] == '5' || magic[1] == '6')) return openPnm(magic[1], error);
+        file_.read(reinterpret_cast<char*>(magic + 2), 6);
+        static const unsigned char PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        if (file_ && std::memcmp(magic, PNG_SIGNATURE, 8) == 0) return openPng(error);
+        error = "'" + filename + "' is not a PNG, PGM, PPM or PBM file";
+        return false;
+    }
+
+    void close() {
+#ifdef LARK_HAVE_ZLIB
+        if (inflating_) inflateEnd(&zs_);
+        inflating_ = false;
+#endif
+        if (file_.is_open()) file_.close();
+    }
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    // Fills the rows of 'band' with the next band.height rows of the image.
+    // Returns false if the file ends early or is corrupt.
+    bool readBand(GrayBitmap& band) {
+        for (int y = band.top; y < band.top + band.height; ++y) {
+            if (rowsRead_ == height_ || !readRow(band.Row(y))) return false;
+            ++rowsRead_;
+        }
+        return true;
+    }
+
+private:
+    enum class Kind { Pbm, Pgm, Ppm, Png };
+
+    // --- PNM ---
+
+    // Next header number, skipping whitespace and # comments.
+    bool pnmNumber(int& value) {
+        int c = file_.get();
+        while (c == '#' || std::isspace(c)) {
+            if (c == '#') {
+                while (c != '\n' && c != EOF) c = file_.get();
+            }
+            c = file_.get();
+        }
+        if (c < '0' || c > '9') return false;
+        long long n = 0;
+        while (c >= '0' && c <= '9') {
+            n = n * 10 + (c - '0');
+            if (n > 0x7FFFFFFF) return false;
+            c = file_.get();
+        }
+        value = static_cast<int>(n);
+        return std::isspace(c); // exactly one whitespace byte ends the header
+    }
+
+    bool openPnm(char type, std::string& error) {
+        kind_ = type == '4' ? Kind::Pbm : type == '5' ? Kind::Pgm : Kind::Ppm;
+        maxValue_ = 1;
+        if (!pnmNumber(width_) || !pnmNumber(height_) || (kind_ != Kind::Pbm && !pnmNumber(maxValue_)) ||
+            width_ < 1 || height_ < 1 || maxValue_ < 1 || maxValue_ > 65535) {
+            error = "Bad PNM header";
+            return false;
+        }
+        int samples = kind_ == Kind::Ppm ? 3 : 1;
+        int bytes = maxValue_ > 255 ? 2 : 1;
+        raw_.resize(kind_ == Kind::Pbm ? (width_ + 7) / 8 : static_cast<size_t>(width_) * samples * bytes);
+        return true;
+    }
+
+    bool readPnmRow(unsigned char* gray) {
+        if (!file_.read(reinterpret_cast<char*>(raw_.data()), static_cast<std::streamsize>(raw_.size()))) return false;
+        if (kind_ == Kind::Pbm) {
+            for (int x = 0; x < width_; ++x) gray[x] = (raw_[x >> 3] >> (7 - (x & 7))) & 1 ? 0 : 255;
+            return true;
+        }
+        int samples = kind_ == Kind::Ppm ? 3 : 1;
+        bool wide = maxValue_ > 255;
+        for (int x = 0; x < width_; ++x) {
+            unsigned v[3];
+            for (int s = 0; s < samples; ++s) {
+                size_t i = static_cast<size_t>(x) * samples + s;
+                unsigned sample = wide ? (raw_[2 * i] << 8) | raw_[2 * i + 1] : raw_[i];
+                v[s] = (sample * 255 + maxValue_ / 2) / maxValue_;
+            }
+            gray[x] = samples == 3 ? Luma(v[0], v[1], v[2]) : static_cast<unsigned char>(v[0]);
+        }
+        return true;
+    }
+
+    // --- PNG ---
+
+    static uint32_t BigEndian32(const unsigned char* p) {
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | p[3];
+    }
+
+    static unsigned char Luma(unsigned r, unsigned g, unsigned b) {
+        return static_cast<unsigned char>((77 * r + 150 * g + 29 * b + 128) >> 8);
+    }
+
+    // Gray 'v' seen through alpha 'a' on white paper
+    static unsigned char OnPaper(unsigned v, unsigned a) {
+        return static_cast<unsigned char>((v * a + 255 * (255 - a) + 127) / 255);
+    }
+
+    // Reads a chunk header; false at end of file.
+    bool pngChunk(uint32_t& length, char type[5]) {
+        unsigned char header[8];
+        if (!file_.read(reinterpret_cast<char*>(header), 8)) return false;
+        length = BigEndian32(header);
+        std::memcpy(type, header + 4, 4);
+        type[4] = 0;
+        return length <= 0x7FFFFFFF;
+    }
+
+    bool openPng(std::string& error) {
+        kind_ = Kind::Png;
+#ifndef LARK_HAVE_ZLIB
+        error = "PNG input needs zlib: rebuild with -DLARK_HAVE_ZLIB -lz, or convert the image to PGM";
+        return false;
+#else
+        uint32_t length;
+        char type[5];
+        unsigned char ihdr[13];
+        if (!pngChunk(length, type) || std::strcmp(type, "IHDR") != 0 || length != 13 ||
+            !file_.read(reinterpret_cast<char*>(ihdr), 13) || !file_.ignore(4)) {
+            error = "Bad PNG header";
+            return false;
+        }
+        uint32_t w = BigEndian32(ihdr), h = BigEndian32(ihdr + 4);
+        bitDepth_ = ihdr[8];
+        colorType_ = ihdr[9];
+        static const int CHANNELS[7] = { 1, 0, 3, 1, 2, 0, 4 };
+        bool depthOk = colorType_ == 0 ? (bitDepth_ == 1 || bitDepth_ == 2 || bitDepth_ == 4 || bitDepth_ == 8 || bitDepth_ == 16) :
+            colorType_ == 3 ? (bitDepth_ == 1 || bitDepth_ == 2 || bitDepth_ == 4 || bitDepth_ == 8) :
+            (bitDepth_ == 8 || bitDepth_ == 16);
+        if (w == 0 || h == 0 || w > 0x7FFFFFFF || h > 0x7FFFFFFF || colorType_ > 6 || CHANNELS[colorType_] == 0 || !depthOk) {
+            error = "Unsupported PNG format";
+            return false;
+        }
+        if (ihdr[12] != 0) {
+            error = "Interlaced PNG files are not supported";
+            return false;
+        }
+        width_ = static_cast<int>(w);
+        height_ = static_cast<int>(h);
+        channels_ = CHANNELS[colorType_];
+        int bitsPerPixel = channels_ * bitDepth_;
+        filterStep_ = std::max(1, bitsPerPixel / 8);
+        raw_.assign(1 + (static_cast<size_t>(width_) * bitsPerPixel + 7) / 8, 0);
+        previous_.assign(raw_.size(), 0);
+
+        // Everything before the image data; only the palette matters here
+        palette_.assign(256, 255);
+        while (true) {
+            if (!pngChunk(length, type)) {
+                error = "PNG file has no image data";
+                return false;
+            }
+            if (std::strcmp(type, "IDAT") == 0) break;
+            if (std::strcmp(type, "PLTE") == 0 || std::strcmp(type, "tRNS") == 0) {
+                std::vector<unsigned char> data(length);
+                if (!file_.read(reinterpret_cast<char*>(data.data()), length)) break;
+                if (type[0] == 'P') {
+                    for (uint32_t i = 0; i < length / 3 && i < 256; ++i) palette_[i] = Luma(data[3 * i], data[3 * i + 1], data[3 * i + 2]);
+                }
+                else if (colorType_ == 3) {
+                    for (uint32_t i = 0; i < length && i < 256; ++i) palette_[i] = OnPaper(palette_[i], data[i]);
+                }
+                file_.ignore(4);
+            }
+            else {
+                file_.ignore(static_cast<std::streamsize>(length) + 4);
+            }
+        }
+        idatLeft_ = length;
+
+        std::memset(&zs_, 0, sizeof(zs_));
+        if (inflateInit(&zs_) != Z_OK) {
+            error = "zlib initialization failed";
+            return false;
+        }
+        inflating_ = true;
+        input_.resize(1 << 16);
+        return true;
+#endif
+    }
+
+#ifdef LARK_HAVE_ZLIB
+    // Refills the inflate input from the IDAT chunks; false once they run out.
+    bool pngFill() {
+        while (idatLeft_ == 0) {
+            uint32_t length;
+            char type[5];
+            if (!file_.ignore(4) || !pngChunk(length, type) || std::strcmp(type, "IDAT") != 0) return false;
+            idatLeft_ = length;
+        }
+        uint32_t n = std::min<uint32_t>(idatLeft_, static_cast<uint32_t>(input_.size()));
+        if (!file_.read(reinterpret_cast<char*>(input_.data()), n)) return false;
+        idatLeft_ -= n;
+        zs_.next_in = input_.data();
+        zs_.avail_in = n;
+        return true;
+    }
+
+    // Undoes the row filter against the previous (unfiltered) row.
+    void unfilter() {
+        unsigned char* row = raw_.data() + 1;
+        const unsigned char* up = previous_.data() + 1;
+        size_t n = raw_.size() - 1;
+        int step = filterStep_;
+        switch (raw_[0]) {
+        case 1:
+            for (size_t i = step; i < n; ++i) row[i] = static_cast<unsigned char>(row[i] + row[i - step]);
+            break;
+        case 2:
+            for (size_t i = 0; i < n; ++i) row[i] = static_cast<unsigned char>(row[i] + up[i]);
+            break;
+        case 3:
+            for (size_t i = 0; i < n; ++i) {
+                int left = i >= static_cast<size_t>(step) ? row[i - step] : 0;
+                row[i] = static_cast<unsigned char>(row[i] + ((left + up[i]) >> 1));
+            }
+            break;
+        case 4:
+            for (size_t i = 0; i < n; ++i) {
+                int a = i >= static_cast<size_t>(step) ? row[i - step] : 0;
+                int b = up[i];
+                int c = i >= static_cast<size_t>(step) ? up[i - step] : 0;
+                int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+                row[i] = static_cast<unsigned char>(row[i] + (pa <= pb && pa <= pc ? a : pb <= pc ? b : c));
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    bool readPngRow(unsigned char* gray) {
+        zs_.next_out = raw_.data();
+        zs_.avail_out = static_cast<uInt>(raw_.size());
+        while (zs_.avail_out > 0) {
+            if (zs_.avail_in == 0 && !pngFill()) return false;
+            int status = inflate(&zs_, Z_NO_FLUSH);
+            if (status == Z_STREAM_END && zs_.avail_out > 0) return false;
+            if (status != Z_OK && status != Z_STREAM_END) return false;
+        }
+        if (raw_[0] > 4) return false;
+        unfilter();
+
+        const unsigned char* p = raw_.data() + 1;
+        if (bitDepth_ < 8) {
+            int perByte = 8 / bitDepth_, mask = (1 << bitDepth_) - 1;
+            for (int x = 0; x < width_; ++x) {
+                int shift = 8 - bitDepth_ * (x % perByte + 1);
+                int v = (p[x / perByte] >> shift) & mask;
+                gray[x] = colorType_ == 3 ? palette_[v] : static_cast<unsigned char>(v * 255 / mask);
+            }
+        }
+        else {
+            // 16-bit samples keep their high byte
+            int stride = bitDepth_ / 8;
+            for (int x = 0; x < width_; ++x) {
+                const unsigned char* s = p + static_cast<size_t>(x) * channels_ * stride;
+                switch (colorType_) {
+                case 0: gray[x] = s[0]; break;
+                case 3: gray[x] = palette_[s[0]]; break;
+                case 4: gray[x] = OnPaper(s[0], s[stride]); break;
+                case 2: gray[x] = Luma(s[0], s[stride], s[2 * stride]); break;
+                default: gray[x] = OnPaper(Luma(s[0], s[stride], s[2 * stride]), s[3 * stride]); break;
+                }
+            }
+        }
+        previous_.swap(raw_);
+        return true;
+    }
+#endif
+
+    bool readRow(unsigned char* gray) {
+#ifdef LARK_HAVE_ZLIB
+        if (kind_ == Kind::Png) return readPngRow(gray);
+#endif
+        return readPnmRow(gray);
+    }
+
+    std::ifstream file_;
+    Kind kind_ = Kind::Pgm;
+    int width_ = 0;
+    int height_ = 0;
+    int rowsRead_ = 0;
+    int maxValue_ = 255;
+    std::vector<unsigned char> raw_; // one packed row as stored (PNG: filter byte first)
+
+    // PNG state
+    int bitDepth_ = 8;
+    int colorType_ = 0;
+    int channels_ = 1;
+    int filterStep_ = 1;
+    std::vector<unsigned char> previous_;
+    std::vector<unsigned char> palette_; // gray level of each palette entry, on paper
+#ifdef LARK_HAVE_ZLIB
+    z_stream zs_;
+    bool inflating_ = false;
+    uint32_t idatLeft_ = 0;
+    std::vector<unsigned char> input_;
+#endif
+};
@@ -0,0 +1,309 @@
+// FILE: lark_image_writer.h
+// PURPOSE: Streams a canvas to disk one band at a time as binary PGM (P5),
+//          PBM (P4) or PNG. Bands are written with a single write call per
+//          band, so output runs at disk speed and the full image never has to
+//          exist in memory.
+//
+//          PNG output is grayscale: 8-bit from a GrayBitmap canvas or 1-bit
+//          from a MonoBitmap canvas. Compile with -DLARK_HAVE_ZLIB (and link
+//          -lz) to deflate the image data; without zlib the PNG is still valid
+//          but its data is stored uncompressed.
+//
+// AUTHOR: hamslices
+//
+// REQUIRES: lark_bitmap.h in the same directory.
+// USAGE: ImageWriter writer;
+//        writer.open("plot.pbm", ImageFormat::Pbm, width, height);
+//        writer.writeBand(band);   // top to bottom, until 'height' rows are in
+//        writer.close();
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#ifdef LARK_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "lark_bitmap.h"
+
+enum class ImageFormat { Pgm, Pbm, Png };
+
+inline bool ParseImageFormat(const std::string& name, ImageFormat& format) {
+    if (name == "pgm") { format = ImageFormat::Pgm; return true; }
+    if (name == "pbm") { format = ImageFormat::Pbm; return true; }
+    if (name == "png") { format = ImageFormat::Png; return true; }
+    return false;
+}
+
+inline const char* ImageFormatExtension(ImageFormat format) {
+    switch (format) {
+    case ImageFormat::Pbm: return "pbm";
+    case ImageFormat::Png: return "png";
+    default: return "pgm";
+    }
+}
+
+// True when the format stores one bit per pixel and so is best fed MonoBitmap bands.
+inline bool ImageFormatIsMono(ImageFormat format) {
+    return format == ImageFormat::Pbm || format == ImageFormat::Png;
+}
+
+class ImageWriter {
+public:
+    ~ImageWriter() { if (file_.is_open()) close(); }
+
+    bool open(const std::string& filename, ImageFormat format, int width, int height) {
+        file_.open(filename, std::ios::out | std::ios::binary);
+        if (!file_) return false;
+        format_ = format;
+        width_ = width;
+        height_ = height;
+        rowsWritten_ = 0;
+        switch (format_) {
+        case ImageFormat::Pgm:
+            file_ << "P5\n" << width_ << " " << height_ << "\n255\n";
+            break;
+        case ImageFormat::Pbm:
+            file_ << "P4\n" << width_ << " " << height_ << "\n";
+            break;
+        case ImageFormat::Png:
+            break; // the PNG header waits for the first band, which sets the bit depth
+        }
+        return static_cast<bool>(file_);
+    }
+
+    void writeBand(const GrayBitmap& band) {
+        if (format_ == ImageFormat::Pgm) {
+            file_.write(reinterpret_cast<const char*>(band.pixels.data()), static_cast<std::streamsize>(band.width) * band.height);
+            rowsWritten_ += band.height;
+            return;
+        }
+        if (format_ == ImageFormat::Png && (!pngStarted_ || !pngMono_)) {
+            if (!pngStarted_) startPng(false);
+            std::vector<unsigned char> line(1 + band.width);
+            for (int y = band.top; y < band.top + band.height; ++y) {
+                line[0] = 0; // filter type: none
+                std::memcpy(&line[1], band.Row(y), band.width);
+                pngRow(line.data(), line.size());
+            }
+            return;
+        }
+        // 1-bit targets: threshold each row the same way MonoBitmap::Set does
+        MonoBitmap row(band.width, 1, 0);
+        for (int y = band.top; y < band.top + band.height; ++y) {
+            const unsigned char* src = band.Row(y);
+            row.Clear(255);
+            for (int x = 0; x < band.width; ++x) {
+                if (src[x] < 128) row.Set(x, 0, 0);
+            }
+            writeMonoRows(row.bits.data(), 1);
+        }
+    }
+
+    void writeBand(const MonoBitmap& band) {
+        if (format_ == ImageFormat::Pgm || (format_ == ImageFormat::Png && pngStarted_ && !pngMono_)) {
+            GrayBitmap row(band.width, 1, 0);
+            for (int y = band.top; y < band.top + band.height; ++y) {
+                for (int x = 0; x < band.width; ++x) row.pixels[x] = band.IsBlack(x, y) ? 0 : 255;
+                writeBand(row);
+            }
+            return;
+        }
+        writeMonoRows(band.bits.data(), band.height);
+    }
+
+    // Finishes the file. Returns false if anything failed to write or fewer
+    // rows than promised were supplied.
+    bool close() {
+        if (format_ == ImageFormat::Png && pngStarted_) finishPng();
+        file_.close();
+        return !file_.fail() && rowsWritten_ == height_;
+    }
+
+private:
+    void writeMonoRows(const unsigned char* rows, int count) {
+        int stride = (width_ + 7) / 8;
+        if (format_ == ImageFormat::Pbm) {
+            file_.write(reinterpret_cast<const char*>(rows), static_cast<std::streamsize>(stride) * count);
+            rowsWritten_ += count;
+            return;
+        }
+        // PNG grayscale uses 1 for white, the opposite of PBM
+        std::vector<unsigned char> line(1 + stride);
+        for (int r = 0; r < count; ++r) {
+            const unsigned char* src = rows + static_cast<size_t>(r) * stride;
+            line[0] = 0; // filter type: none
+            for (int i = 0; i < stride; ++i) line[1 + i] = static_cast<unsigned char>(~src[i]);
+            if (!pngStarted_) startPng(true);
+            pngRow(line.data(), line.size());
+        }
+    }
+
+    // --- PNG ---
+
+    // The table is built once; a function-local static is initialized
+    // thread-safely, so writers on several threads can share it.
+    static uint32_t Crc32(uint32_t crc, const unsigned char* data, size_t size) {
+        static const auto table = [] {
+            std::array<uint32_t, 256> t{};
+            for (uint32_t n = 0; n < 256; ++n) {
+                uint32_t c = n;
+                for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[n] = c;
+            }
+            return t;
+        }();
+        crc = ~crc;
+        for (size_t i = 0; i < size; ++i) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    void putU32(std::vector<unsigned char>& out, uint32_t v) {
+        out.push_back(static_cast<unsigned char>(v >> 24));
+        out.push_back(static_cast<unsigned char>(v >> 16));
+        out.push_back(static_cast<unsigned char>(v >> 8));
+        out.push_back(static_cast<unsigned char>(v));
+    }
+
+    void writeChunk(const char* type, const unsigned char* data, size_t size) {
+        std::vector<unsigned char> head;
+        putU32(head, static_cast<uint32_t>(size));
+        head.insert(head.end(), type, type + 4);
+        uint32_t crc = Crc32(0, head.data() + 4, 4);
+        crc = Crc32(crc, data, size);
+        std::vector<unsigned char> tail;
+        putU32(tail, crc);
+        file_.write(reinterpret_cast<const char*>(head.data()), head.size());
+        if (size > 0) file_.write(reinterpret_cast<const char*>(data), size);
+        file_.write(reinterpret_cast<const char*>(tail.data()), tail.size());
+    }
+
+    void startPng(bool mono) {
+        pngMono_ = mono;
+        static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+        file_.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+        std::vector<unsigned char> ihdr;
+        putU32(ihdr, static_cast<uint32_t>(width_));
+        putU32(ihdr, static_cast<uint32_t>(height_));
+        ihdr.push_back(pngMono_ ? 1 : 8); // bit depth
+        ihdr.push_back(0);                // colour type: grayscale
+        ihdr.push_back(0);                // compression: deflate
+        ihdr.push_back(0);                // filter method
+        ihdr.push_back(0);                // no interlace
+        writeChunk("IHDR", ihdr.data(), ihdr.size());
+#ifdef LARK_HAVE_ZLIB
+        zstream_ = z_stream();
+        deflateInit(&zstream_, Z_DEFAULT_COMPRESSION);
+        zout_.resize(kIdatSize);
+        zstream_.next_out = zout_.data();
+        zstream_.avail_out = static_cast<uInt>(zout_.size());
+#else
+        adler_ = 1;
+        pending_.clear();
+        zlibHeaderWritten_ = false;
+#endif
+        pngStarted_ = true;
+    }
+
+    void pngRow(const unsigned char* line, size_t size) {
+#ifdef LARK_HAVE_ZLIB
+        zstream_.next_in = const_cast<Bytef*>(line);
+        zstream_.avail_in = static_cast<uInt>(size);
+        deflateChunks(Z_NO_FLUSH);
+#else
+        updateAdler(line, size);
+        pending_.insert(pending_.end(), line, line + size);
+        while (pending_.size() >= kStoredBlockSize) writeStoredBlock(kStoredBlockSize, false);
+#endif
+        ++rowsWritten_;
+    }
+
+    void finishPng() {
+#ifdef LARK_HAVE_ZLIB
+        zstream_.next_in = nullptr;
+        zstream_.avail_in = 0;
+        deflateChunks(Z_FINISH);
+        deflateEnd(&zstream_);
+#else
+        writeStoredBlock(pending_.size(), true);
+#endif
+        writeChunk("IEND", nullptr, 0);
+        pngStarted_ = false;
+    }
+
+#ifdef LARK_HAVE_ZLIB
+    // Feeds zlib and writes an IDAT chunk each time the output buffer fills,
+    // plus whatever is left once the stream is finished.
+    void deflateChunks(int flush) {
+        while (true) {
+            int status = deflate(&zstream_, flush);
+            if (zstream_.avail_out == 0) {
+                writeChunk("IDAT", zout_.data(), zout_.size());
+                zstream_.next_out = zout_.data();
+                zstream_.avail_out = static_cast<uInt>(zout_.size());
+                continue;
+            }
+            if (flush != Z_FINISH || status == Z_STREAM_END) break;
+        }
+        if (flush == Z_FINISH && zstream_.avail_out < zout_.size()) {
+            writeChunk("IDAT", zout_.data(), zout_.size() - zstream_.avail_out);
+        }
+    }
+
+    static const size_t kIdatSize = 1 << 16;
+    z_stream zstream_;
+    std::vector<unsigned char> zout_;
+#else
+    void updateAdler(const unsigned char* data, size_t size) {
+        uint32_t a = adler_ & 0xFFFF, b = adler_ >> 16;
+        while (size > 0) {
+            // 5552 is the most bytes that can be summed before b may overflow
+            size_t n = size < 5552 ? size : 5552;
+            size -= n;
+            while (n--) { a += *data++; b += a; }
+            a %= 65521;
+            b %= 65521;
+        }
+        adler_ = (b << 16) | a;
+    }
+
+    // Writes the first 'len' pending bytes as one stored deflate block in its
+    // own IDAT chunk. The final block also carries the zlib trailer.
+    void writeStoredBlock(size_t len, bool final) {
+        std::vector<unsigned char> block;
+        if (!zlibHeaderWritten_) {
+            block.push_back(0x78); // deflate, 32K window
+            block.push_back(0x01); // no dictionary, fastest
+            zlibHeaderWritten_ = true;
+        }
+        block.push_back(final ? 1 : 0);
+        block.push_back(static_cast<unsigned char>(len));
+        block.push_back(static_cast<unsigned char>(len >> 8));
+        block.push_back(static_cast<unsigned char>(~len));
+        block.push_back(static_cast<unsigned char>(~len >> 8));
+        block.insert(block.end(), pending_.begin(), pending_.begin() + len);
+        pending_.erase(pending_.begin(), pending_.begin() + len);
+        if (final) putU32(block, adler_);
+        writeChunk("IDAT", block.data(), block.size());
+    }
+
+    static const size_t kStoredBlockSize = 65535;
+    uint32_t adler_ = 1;
+    bool zlibHeaderWritten_ = false;
+    std::vector<unsigned char> pending_;
+#endif
+
+    std::ofstream file_;
+    ImageFormat format_ = ImageFormat::Pgm;
+    int width_ = 0;
+    int height_ = 0;
+    int rowsWritten_ = 0;
+    bool pngMono_ = true;
+    bool pngStarted_ = false;
+};
@@ -0,0 +1,91 @@
+// FILE: lark_parallel.h
+// PURPOSE: Small threading helpers for the sample tools, built on std::thread.
+//
+// AUTHOR: hamslices
+//
+// USAGE: ParallelOrdered(chunkCount, threads, 2 * threads,
+//            [&](size_t i) { /* work on chunk i, any thread */ },
+//            [&](size_t i) { /* write chunk i, calling thread, in order */ });
+
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <system_error>
+
+// Worker count to use when the user did not ask for one.
+inline unsigned DefaultThreadCount() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+// Runs produce(i) for every i in [0, count) on 'threads' workers and
+// consume(i) on the calling thread strictly in index order. Workers never
+// run more than 'window' items ahead of the consumer, which bounds how much
+// produced output is held at once. With one thread everything runs inline.
+// Workers take items as they go, so if some threads cannot be started the
+// rest do all the work; if none can, everything runs inline.
+template <typename Produce, typename Consume>
+void ParallelOrdered(size_t count, unsigned threads, size_t window, Produce produce, Consume consume) {
+    auto runInline = [&]() {
+        for (size_t i = 0; i < count; ++i) {
+            produce(i);
+            consume(i);
+        }
+    };
+    if (threads <= 1 || count <= 1) {
+        runInline();
+        return;
+    }
+    if (window < threads) window = threads;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<char> done(count, 0);
+    size_t next = 0, consumed = 0;
+
+    auto worker = [&]() {
+        while (true) {
+            size_t i;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return next >= count || next < consumed + window; });
+                if (next >= count) return;
+                i = next++;
+            }
+            produce(i);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done[i] = 1;
+            }
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    try {
+        for (unsigned t = 0; t < threads; ++t) pool.emplace_back(worker);
+    }
+    catch (const std::system_error&) {
+        // Carry on with the workers that started
+    }
+    if (pool.empty()) {
+        runInline();
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            changed.wait(lock, [&] { return done[i] != 0; });
+        }
+        consume(i);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            consumed = i + 1;
+        }
+        changed.notify_all();
+    }
+    for (auto& t : pool) t.join();
+}
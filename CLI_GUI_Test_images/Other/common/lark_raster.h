@@ -0,0 +1,302 @@
+// FILE: lark_raster.h
+// PURPOSE: Drawing primitives shared by the sample generators, for a
+//          GrayBitmap or MonoBitmap band in full-canvas coordinates.
+//
+//          Every primitive clips once against the band and then writes whole
+//          spans with FillSpan; nothing is bounds-checked per dot.
+//          - FillRect: one span per row.
+//          - DrawLine: a thick line, as if a thickness x thickness square
+//            were stamped at every dot of its Bresenham line, but drawn as
+//            one span per row: the covered span of a row runs from the
+//            leftmost to the rightmost dot of the rows within half the
+//            thickness of it, which two walkers trailing and leading the
+//            row find without storing the line.
+//          - DrawDashedLine: the same footprint for every dash; horizontal
+//            and vertical lines (plot gridlines) become one rectangle per
+//            dash, starting at the first dash that reaches the band. A
+//            starting phase keeps the dashes of a polyline in step.
+//          - FillPattern / FillPatternSpan: a repeating 1-bit tile, such as
+//            the diagonal hatch under the flux trace. Tiles whose width
+//            divides 8 are OR'd into 1-bit rows a byte at a time.
+//          - ScanlineRuns: merges spans handed over left to right on one
+//            row into as few FillSpan calls as possible.
+//
+// AUTHOR: hamslices
+//
+// REQUIRES: lark_bitmap.h in the same directory.
+// USAGE: DrawLine(band, x1, y1, x2, y2, 3, 0);
+//        DrawDashedLine(band, x, top, x, bottom, 1, 0, 5, 5);
+//        FillPatternSpan(band, left, right, y, FillPattern::Hatch(8), 0);
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+
+#include "lark_bitmap.h"
+
+// Blackens (or paints 'color' into) [x, x + w) x [y, y + h)
+template <typename Bitmap>
+void FillRect(Bitmap& band, int x, int y, int w, int h, unsigned char color) {
+    int x0 = std::max(x, 0), x1 = std::min(x + w, band.width);
+    int y0 = std::max(y, band.top), y1 = std::min(y + h, band.top + band.height);
+    if (x0 >= x1) return;
+    for (int row = y0; row < y1; ++row) band.FillSpan(x0, x1, row, color);
+}
+
+// Integer Bresenham walk from (x1, y1) to (x2, y2), one dot per step.
+struct LineWalker {
+    int x, y, dx, dy, sx, sy, err;
+
+    LineWalker(int x1, int y1, int x2, int y2)
+        : x(x1), y(y1), dx(std::abs(x2 - x1)), dy(-std::abs(y2 - y1)),
+          sx(x1 < x2 ? 1 : -1), sy(y1 < y2 ? 1 : -1), err(dx + dy) {}
+
+    int steps() const { return std::max(dx, -dy) + 1; } // dots from here to the end, if at the start
+    void step() {
+        int e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x += sx; }
+        if (e2 <= dx) { err += dx; y += sy; }
+    }
+};
+
+// The next 'count' dots of a walk, a row at a time in walk order: the
+// leftmost and rightmost dot of each row. Past the last row it stays on
+// it and reports ended().
+class LineRows {
+public:
+    LineRows(const LineWalker& start, int count) : walker_(start), remaining_(count) { next(); }
+
+    int y() const { return y_; }
+    int minX() const { return minX_; }
+    int maxX() const { return maxX_; }
+    bool ended() const { return ended_; }
+
+    void next() {
+        if (remaining_ == 0) {
+            ended_ = true;
+            return;
+        }
+        y_ = walker_.y;
+        minX_ = maxX_ = walker_.x;
+        while (true) {
+            if (--remaining_ > 0) walker_.step();
+            if (remaining_ == 0 || walker_.y != y_) break;
+            minX_ = std::min(minX_, walker_.x);
+            maxX_ = std::max(maxX_, walker_.x);
+        }
+    }
+
+private:
+    LineWalker walker_;
+    int remaining_;
+    int y_ = 0, minX_ = 0, maxX_ = 0;
+    bool ended_ = false;
+};
+
+// The 'count' dots from 'start' on, each widened to a square of side
+// 2 * half + 1. Row k of the footprint is covered from the line's
+// leftmost to its rightmost dot on rows k - half .. k + half; as x only
+// moves one way along a line, those are the ends of the trailing and
+// leading rows of that window.
+template <typename Bitmap>
+void DrawLineDots(Bitmap& band, const LineWalker& start, int count, int half, unsigned char color) {
+    const int top = band.top, bottom = band.top + band.height - 1;
+    const int sy = start.sy;
+    LineRows trail(start, count), lead(start, count);
+    for (int k = -half;; ++k) {
+        if (k - half > 0) {
+            trail.next();
+            if (trail.ended()) break;
+        }
+        if (k > -half) lead.next();
+
+        int y = start.y + sy * k; // a line visits every row between its ends
+        if (sy > 0 ? y > bottom : y < top) break; // past the band for good
+        if (y < top || y > bottom) continue;
+
+        int left = start.sx > 0 ? trail.minX() : lead.minX();
+        int right = start.sx > 0 ? lead.maxX() : trail.maxX();
+        int x0 = std::max(left - half, 0), x1 = std::min(right + half + 1, band.width);
+        if (x0 < x1) band.FillSpan(x0, x1, y, color);
+    }
+}
+
+template <typename Bitmap>
+void DrawLine(Bitmap& band, int x1, int y1, int x2, int y2, int thickness, unsigned char color) {
+    int half = thickness / 2;
+    if (!band.IntersectsRows(std::min(y1, y2) - half, std::max(y1, y2) + half)) return;
+    LineWalker walker(x1, y1, x2, y2);
+    DrawLineDots(band, walker, walker.steps(), half, color);
+}
+
+// Dots 0 .. dash - 1 of every dash + gap steps are drawn, counted from
+// (x1, y1), which is dot 'phase' of the pattern; a polyline passes the dots
+// it has drawn so far to keep its dashes running across the joins.
+// gap == 0 is a solid line.
+template <typename Bitmap>
+void DrawDashedLine(Bitmap& band, int x1, int y1, int x2, int y2, int thickness, unsigned char color, int dash, int gap, long long phase = 0) {
+    int half = thickness / 2;
+    if (!band.IntersectsRows(std::min(y1, y2) - half, std::max(y1, y2) + half)) return;
+    if (gap == 0) {
+        dash = std::max(std::abs(x2 - x1), std::abs(y2 - y1)) + 1;
+        phase = 0;
+    }
+    const int period = dash + gap;
+    const int offset = static_cast<int>(phase % period); // dash k starts at dot k * period - offset
+
+    if (x1 == x2 || y1 == y2) {
+        // Each dash is a rectangle. Vertical runs (the plot gridlines) span
+        // the whole canvas, so start at the first dash that reaches the band.
+        bool vertical = x1 == x2 && y1 != y2;
+        int from = vertical ? y1 : x1, to = vertical ? y2 : x2;
+        int s = from <= to ? 1 : -1, length = std::abs(to - from);
+        int firstStep = 0;
+        if (vertical) {
+            int lo = band.top - half, hi = band.top + band.height - 1 + half;
+            firstStep = std::max(0, s > 0 ? lo - from : from - hi);
+        }
+        for (int a = (firstStep + offset) / period * period - offset; a <= length; a += period) {
+            int lo = std::max(a, 0), b = std::min(a + dash - 1, length);
+            if (b < lo) continue;
+            int p0 = std::min(from + s * lo, from + s * b) - half, p1 = std::max(from + s * lo, from + s * b) + half + 1;
+            if (vertical) {
+                if (s > 0 ? p0 >= band.top + band.height : p1 <= band.top) break;
+                FillRect(band, x1 - half, p0, 2 * half + 1, p1 - p0, color);
+            }
+            else {
+                FillRect(band, p0, y1 - half, p1 - p0, 2 * half + 1, color);
+            }
+        }
+        return;
+    }
+
+    LineWalker walker(x1, y1, x2, y2);
+    int steps = walker.steps(), walked = 0;
+    for (int a = -offset; a < steps; a += period) {
+        int lo = std::max(a, 0), count = std::min(a + dash, steps) - lo;
+        if (count <= 0) continue;
+        for (; walked < lo; ++walked) walker.step();
+        DrawLineDots(band, walker, count, half, color);
+    }
+}
+
+// Outline of an arrowhead with its tip at (x, y), 'size' dots long
+template <typename Bitmap>
+void DrawTriangle(Bitmap& band, int x, int y, int size, bool pointsRight, unsigned char color) {
+    int dir = pointsRight ? 1 : -1;
+    DrawLine(band, x, y, x + (size * dir), y - (size / 2), 1, color);
+    DrawLine(band, x, y, x + (size * dir), y + (size / 2), 1, color);
+    DrawLine(band, x + (size * dir), y - (size / 2), x + (size * dir), y + (size / 2), 1, color);
+}
+
+// A 1-bit tile of up to 64 x 64 dots repeated across the canvas from its
+// origin. Bit x of rows[y] (LSB first) is dot (x, y) of the tile.
+struct FillPattern {
+    int width = 8;
+    int height = 8;
+    std::vector<uint64_t> rows;
+    std::vector<unsigned char> rowBytes; // each row repeated over 8 dots, MSB first, when 8 % width == 0
+
+    FillPattern(int w, int h, std::vector<uint64_t> tileRows) : width(w), height(h), rows(std::move(tileRows)) {
+        if (8 % width != 0) return;
+        for (uint64_t bits : rows) {
+            unsigned char byte = 0;
+            for (int dot = 0; dot < 8; ++dot) {
+                if ((bits >> (dot % width)) & 1) byte |= static_cast<unsigned char>(0x80 >> dot);
+            }
+            rowBytes.push_back(byte);
+        }
+    }
+
+    bool At(int x, int y) const { return (rows[y % height] >> (x % width)) & 1; }
+
+    // Diagonal hatch: the dots where (x + y) % spacing == 0
+    static FillPattern Hatch(int spacing) {
+        std::vector<uint64_t> tile(spacing);
+        for (int y = 0; y < spacing; ++y) tile[y] = uint64_t(1) << ((spacing - y % spacing) % spacing);
+        return FillPattern(spacing, spacing, std::move(tile));
+    }
+
+    // The other diagonal: the dots where (x - y) % spacing == 0
+    static FillPattern BackHatch(int spacing) {
+        std::vector<uint64_t> tile(spacing);
+        for (int y = 0; y < spacing; ++y) tile[y] = uint64_t(1) << (y % spacing);
+        return FillPattern(spacing, spacing, std::move(tile));
+    }
+};
+
+// Paints the set dots of the pattern in [x0, x1) of row y; the others are
+// left alone.
+template <typename Bitmap>
+void FillPatternSpan(Bitmap& band, int x0, int x1, int y, const FillPattern& pattern, unsigned char color) {
+    if (y < band.top || y >= band.top + band.height) return;
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, band.width);
+    uint64_t bits = pattern.rows[y % pattern.height];
+    if (x0 >= x1 || bits == 0) return;
+    int phase = x0 % pattern.width;
+    for (int x = x0; x < x1; ++x) {
+        if ((bits >> phase) & 1) band.Set(x, y, color);
+        if (++phase == pattern.width) phase = 0;
+    }
+}
+
+template <>
+inline void FillPatternSpan(MonoBitmap& band, int x0, int x1, int y, const FillPattern& pattern, unsigned char color) {
+    if (y < band.top || y >= band.top + band.height) return;
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, band.width);
+    if (x0 >= x1) return;
+    if (pattern.rowBytes.empty()) {
+        for (int x = x0; x < x1; ++x) {
+            if (pattern.At(x, y)) band.Set(x, y, color);
+        }
+        return;
+    }
+    unsigned char byte = pattern.rowBytes[y % pattern.height];
+    if (byte == 0) return;
+
+    unsigned char* row = band.Row(y);
+    bool black = color < 128;
+    int first = x0 >> 3, last = (x1 - 1) >> 3;
+    for (int i = first; i <= last; ++i) {
+        unsigned char mask = byte;
+        if (i == first) mask &= static_cast<unsigned char>(0xFF >> (x0 & 7));
+        if (i == last) mask &= static_cast<unsigned char>(0xFF << (7 - ((x1 - 1) & 7)));
+        row[i] = black ? (row[i] | mask) : (row[i] & ~mask);
+    }
+}
+
+template <typename Bitmap>
+void FillPatternRect(Bitmap& band, int x, int y, int w, int h, const FillPattern& pattern, unsigned char color) {
+    int y0 = std::max(y, band.top), y1 = std::min(y + h, band.top + band.height);
+    for (int row = y0; row < y1; ++row) FillPatternSpan(band, x, x + w, row, pattern, color);
+}
+
+// Fills spans handed over left to right on one scanline, merging the ones
+// that touch or overlap into a single run per FillSpan.
+template <typename Bitmap>
+class ScanlineRuns {
+public:
+    ScanlineRuns(Bitmap& band, int y, unsigned char color) : band_(band), y_(y), color_(color) {}
+    ~ScanlineRuns() { flush(); }
+
+    void add(int x0, int x1) {
+        if (x0 > end_) {
+            flush();
+            start_ = x0;
+        }
+        end_ = std::max(end_, x1);
+    }
+
+private:
+    void flush() { band_.FillSpan(std::max(start_, 0), std::min(end_, band_.width), y_, color_); }
+
+    Bitmap& band_;
+    int y_;
+    unsigned char color_;
+    int start_ = 0, end_ = 0; // current run, [start, end)
+};
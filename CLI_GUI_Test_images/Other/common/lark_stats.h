@@ -0,0 +1,127 @@
+// FILE: lark_stats.h
+// PURPOSE: One-pass, constant-memory statistics for values that arrive as a
+//          stream (rows being parsed, a file being followed).
+//          - RunningStats: count, mean, variance, min and max (Welford's
+//            update, so there is no catastrophic cancellation).
+//          - QuantileSketch: any quantile to within a fixed relative error
+//            (0.5% by default) from logarithmic buckets. Unlike marker-based
+//            estimators such as P-squared it does not care about arrival
+//            order, which matters for data that drifts over a solar cycle.
+//
+// AUTHOR: hamslices
+//
+// USAGE: RunningStats stats;
+//        QuantileSketch sketch;
+//        for (double x : values) { stats.add(x); sketch.add(x); }
+//        double sigma = stats.stdDev(), top = sketch.quantile(0.99);
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <algorithm>
+#include <vector>
+
+class RunningStats {
+public:
+    void add(double x) {
+        ++count_;
+        double delta = x - mean_;
+        mean_ += delta / count_;
+        m2_ += delta * (x - mean_);
+        min_ = std::min(min_, x);
+        max_ = std::max(max_, x);
+    }
+
+    size_t count() const { return count_; }
+    double mean() const { return mean_; }
+    // Population variance (divides by n), as the plot's 3-sigma range uses.
+    double variance() const { return count_ > 0 ? m2_ / count_ : 0.0; }
+    double sampleVariance() const { return count_ > 1 ? m2_ / (count_ - 1) : 0.0; }
+    double stdDev() const { return std::sqrt(variance()); }
+    double min() const { return min_; }
+    double max() const { return max_; }
+
+private:
+    size_t count_ = 0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;
+    double min_ = std::numeric_limits<double>::infinity();
+    double max_ = -std::numeric_limits<double>::infinity();
+};
+
+// Quantile estimates with a bounded relative error, whatever order the data
+// arrives in (the DDSketch idea). Values are counted in logarithmic buckets
+// whose width is 2 * accuracy of their value, so memory depends on the range
+// of the values (a few hundred buckets for a decade of flux), not their
+// number. Values closer to zero than minMagnitude are counted as zero.
+class QuantileSketch {
+public:
+    explicit QuantileSketch(double relativeAccuracy = 0.005, double minMagnitude = 1e-9)
+        : gamma_((1.0 + relativeAccuracy) / (1.0 - relativeAccuracy)), logGamma_(std::log(gamma_)), minMagnitude_(minMagnitude) {}
+
+    void add(double x) {
+        ++count_;
+        if (x > minMagnitude_) positive_.add(key(x));
+        else if (x < -minMagnitude_) negative_.add(key(-x));
+        else ++zeros_;
+    }
+
+    size_t count() const { return count_; }
+
+    // q in [0, 1]. Returns the bucket value holding the element of rank
+    // q * (count - 1); NaN before the first value.
+    double quantile(double q) const {
+        if (count_ == 0) return std::numeric_limits<double>::quiet_NaN();
+        q = std::min(1.0, std::max(0.0, q));
+        size_t rank = static_cast<size_t>(q * (count_ - 1));
+        size_t seen = 0;
+        // Negatives first, most negative (largest magnitude) at the front
+        for (size_t i = negative_.counts.size(); i-- > 0;) {
+            seen += negative_.counts[i];
+            if (seen > rank) return -value(negative_.firstKey + static_cast<int>(i));
+        }
+        seen += zeros_;
+        if (seen > rank) return 0.0;
+        for (size_t i = 0; i < positive_.counts.size(); ++i) {
+            seen += positive_.counts[i];
+            if (seen > rank) return value(positive_.firstKey + static_cast<int>(i));
+        }
+        return value(positive_.firstKey + static_cast<int>(positive_.counts.size()) - 1);
+    }
+
+private:
+    // Counts for a contiguous run of bucket keys, grown at either end
+    struct Store {
+        int firstKey = 0;
+        std::vector<size_t> counts;
+
+        void add(int k) {
+            if (counts.empty()) {
+                firstKey = k;
+                counts.push_back(0);
+            }
+            else if (k < firstKey) {
+                counts.insert(counts.begin(), static_cast<size_t>(firstKey - k), 0);
+                firstKey = k;
+            }
+            else if (k >= firstKey + static_cast<int>(counts.size())) {
+                counts.resize(static_cast<size_t>(k - firstKey) + 1, 0);
+            }
+            ++counts[static_cast<size_t>(k - firstKey)];
+        }
+    };
+
+    int key(double magnitude) const { return static_cast<int>(std::ceil(std::log(magnitude) / logGamma_)); }
+    // Midpoint (in relative terms) of bucket k, which covers (gamma^(k-1), gamma^k]
+    double value(int k) const { return 2.0 * std::pow(gamma_, k) / (gamma_ + 1.0); }
+
+    double gamma_;
+    double logGamma_;
+    double minMagnitude_;
+    size_t count_ = 0;
+    size_t zeros_ = 0;
+    Store positive_;
+    Store negative_;
+};
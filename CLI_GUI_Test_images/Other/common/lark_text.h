@@ -0,0 +1,162 @@
+// FILE: lark_text.h
+// PURPOSE: Caption and label text for the sample generators, drawn with the
+//          public domain font8x8_basic font at any integer scale into a
+//          GrayBitmap or MonoBitmap band.
+//
+//          Each scale is rendered once into a glyph cache:
+//          - packed rows (8 * scale dots = exactly 'scale' bytes, MSB first)
+//            that are shifted and OR'd into 1-bit rows a byte at a time
+//          - runs of set dots per row that are memset into 8-bit rows
+//          Clipping happens once per glyph; only glyphs that straddle the
+//          left or right edge fall back to dot-by-dot drawing.
+//
+// AUTHOR: hamslices
+//
+// REQUIRES: font8x8_basic.h and lark_bitmap.h in the same directory.
+// USAGE: DrawText(band, x, y, "Penticton 10.7cm Solar Flux", 2, 0);
+//        int width = TextWidth(label, 2);
+
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cstring>
+#include <algorithm>
+
+#include "font8x8_basic.h"
+#include "lark_bitmap.h"
+
+const int FONT_GLYPH_SIZE = 8;
+
+// Every font8x8_basic glyph at one scale.
+class GlyphSet {
+public:
+    struct Span { unsigned short offset, length; };
+
+    explicit GlyphSet(int scale) : scale_(scale), rowBytes_(scale) {
+        bits_.assign(static_cast<size_t>(128) * FONT_GLYPH_SIZE * rowBytes_, 0);
+        spanStart_.reserve(static_cast<size_t>(128) * FONT_GLYPH_SIZE + 1);
+        for (int c = 0; c < 128; ++c) {
+            for (int row = 0; row < FONT_GLYPH_SIZE; ++row) {
+                unsigned char* packed = &bits_[(static_cast<size_t>(c) * FONT_GLYPH_SIZE + row) * rowBytes_];
+                spanStart_.push_back(static_cast<unsigned>(spans_.size()));
+                unsigned char fontRow = font8x8_basic[c][row];
+                for (int col = 0; col < FONT_GLYPH_SIZE; ++col) {
+                    if (!((fontRow >> col) & 1)) continue; // bit 0 is the leftmost dot
+                    for (int sx = 0; sx < scale; ++sx) {
+                        int dot = col * scale + sx;
+                        packed[dot >> 3] |= static_cast<unsigned char>(0x80 >> (dot & 7));
+                    }
+                    // Neighbouring set columns join into one run
+                    if (spans_.size() > spanStart_.back() &&
+                        spans_.back().offset + spans_.back().length == col * scale) {
+                        spans_.back().length = static_cast<unsigned short>(spans_.back().length + scale);
+                    }
+                    else {
+                        spans_.push_back({ static_cast<unsigned short>(col * scale), static_cast<unsigned short>(scale) });
+                    }
+                }
+            }
+        }
+        spanStart_.push_back(static_cast<unsigned>(spans_.size()));
+    }
+
+    int scale() const { return scale_; }
+    // Font row 'row' (0-7) of glyph c, 'scale' bytes wide
+    const unsigned char* Packed(int c, int row) const {
+        return &bits_[(static_cast<size_t>(c) * FONT_GLYPH_SIZE + row) * rowBytes_];
+    }
+    const Span* SpansBegin(int c, int row) const { return spans_.data() + spanStart_[static_cast<size_t>(c) * FONT_GLYPH_SIZE + row]; }
+    const Span* SpansEnd(int c, int row) const { return spans_.data() + spanStart_[static_cast<size_t>(c) * FONT_GLYPH_SIZE + row + 1]; }
+
+private:
+    int scale_;
+    int rowBytes_;
+    std::vector<unsigned char> bits_;
+    std::vector<Span> spans_;
+    std::vector<unsigned> spanStart_;
+};
+
+// The shared cache. Sets are built on first use and never move, so the
+// reference stays valid; safe to call from several threads.
+inline const GlyphSet& GlyphsAtScale(int scale) {
+    static std::mutex mutex;
+    static std::map<int, GlyphSet> sets;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = sets.find(scale);
+    if (it == sets.end()) it = sets.emplace(scale, GlyphSet(scale)).first;
+    return it->second;
+}
+
+inline int TextWidth(std::string_view text, int scale) {
+    int width = 0;
+    for (char c : text) {
+        if (static_cast<unsigned char>(c) < 128) width += FONT_GLYPH_SIZE * scale; // other bytes are skipped
+    }
+    return width;
+}
+
+// Draws canvas rows [y0, y1] of glyph c, whose top-left dot is at (x, y).
+// The rows must be in the band and the glyph inside it horizontally.
+inline void BlitGlyphRows(GrayBitmap& band, const GlyphSet& glyphs, int c, int x, int y, int y0, int y1, unsigned char color) {
+    int scale = glyphs.scale();
+    for (int pY = y0; pY <= y1; ++pY) {
+        int row = (pY - y) / scale;
+        unsigned char* dst = band.Row(pY) + x;
+        for (const GlyphSet::Span* s = glyphs.SpansBegin(c, row); s != glyphs.SpansEnd(c, row); ++s) {
+            std::memset(dst + s->offset, color, s->length);
+        }
+    }
+}
+
+inline void BlitGlyphRows(MonoBitmap& band, const GlyphSet& glyphs, int c, int x, int y, int y0, int y1, unsigned char color) {
+    int scale = glyphs.scale();
+    int shift = x & 7;
+    bool black = color < 128;
+    for (int pY = y0; pY <= y1; ++pY) {
+        const unsigned char* src = glyphs.Packed(c, (pY - y) / scale);
+        unsigned char* dst = band.Row(pY) + (x >> 3);
+        for (int i = 0; i < scale; ++i) {
+            unsigned char lo = static_cast<unsigned char>(src[i] >> shift);
+            unsigned char hi = shift ? static_cast<unsigned char>(src[i] << (8 - shift)) : 0;
+            if (black) {
+                dst[i] |= lo;
+                if (hi) dst[i + 1] |= hi;
+            }
+            else {
+                dst[i] &= static_cast<unsigned char>(~lo);
+                if (hi) dst[i + 1] &= static_cast<unsigned char>(~hi);
+            }
+        }
+    }
+}
+
+// Draws text with its top-left dot at (x, y) in canvas coordinates. Only the
+// set dots of each glyph are drawn; the background is left alone. Bytes
+// outside 0-127 are skipped without taking up space.
+template <typename Bitmap>
+void DrawText(Bitmap& band, int x, int y, std::string_view text, int scale, unsigned char color) {
+    int glyphSize = FONT_GLYPH_SIZE * scale;
+    if (scale <= 0 || !band.IntersectsRows(y, y + glyphSize - 1)) return;
+    const GlyphSet& glyphs = GlyphsAtScale(scale);
+    int y0 = std::max(y, band.top), y1 = std::min(y + glyphSize - 1, band.top + band.height - 1);
+    for (char ch : text) {
+        int c = static_cast<unsigned char>(ch);
+        if (c > 127) continue;
+        if (x >= 0 && x + glyphSize <= band.width) {
+            BlitGlyphRows(band, glyphs, c, x, y, y0, y1, color);
+        }
+        else if (x + glyphSize > 0 && x < band.width) {
+            // Straddles an edge: draw the visible dots one at a time
+            for (int pY = y0; pY <= y1; ++pY) {
+                const unsigned char* packed = glyphs.Packed(c, (pY - y) / scale);
+                for (int dot = std::max(0, -x); dot < std::min(glyphSize, band.width - x); ++dot) {
+                    if ((packed[dot >> 3] >> (7 - (dot & 7))) & 1) band.Set(x + dot, pY, color);
+                }
+            }
+        }
+        x += glyphSize;
+    }
+}
@@ -0,0 +1,204 @@
+// FILE: maze_bench.cpp
+// PURPOSE: Measures maze generation with the original vector<vector<Cell>>
+//          layout next to the bit-packed MazeGrid, on the same seed, and
+//          checks that both carve exactly the same walls. Then times tiled
+//          generation on 1 thread and on every core (at least 2), and checks
+//          that it gives the same perfect maze on 1, 3, 8 and that many
+//          threads, so the check means something on a single-core host too.
+//
+// AUTHOR: hamslices
+//
+// REQUIRES: maze_grid.h in the same directory; lark_parallel.h in ../../common.
+// USAGE: ./maze_bench [<cols>x<rows> ...]      (default 50x70 1000x1000 4000x4000)
+
+#include <iostream>
+#include <vector>
+#include <stack>
+#include <random>
+#include <string>
+#include <chrono>
+#include <iomanip>
+#include <cstdio>
+#include <numeric>
+#include <algorithm>
+
+#include "maze_grid.h"
+
+// --- ORIGINAL IMPLEMENTATION (reference) ---
+
+struct Cell {
+    bool visited = false;
+    bool walls[4] = { true, true, true, true }; // Top, Right, Bottom, Left
+};
+
+void ReferenceGenerate(std::vector<std::vector<Cell>>& maze_, int width_, int height_, std::mt19937& gen) {
+    std::stack<std::pair<int, int>> stack;
+    std::uniform_int_distribution<> distrib_w(0, width_ - 1);
+    std::uniform_int_distribution<> distrib_h(0, height_ - 1);
+
+    int start_x = distrib_w(gen);
+    int start_y = distrib_h(gen);
+
+    maze_[start_y][start_x].visited = true;
+    stack.push({ start_x, start_y });
+
+    while (!stack.empty()) {
+        std::pair<int, int> current = stack.top();
+        int x = current.first;
+        int y = current.second;
+
+        std::vector<int> neighbors;
+        if (y > 0 && !maze_[y - 1][x].visited) neighbors.push_back(0); // Top
+        if (x < width_ - 1 && !maze_[y][x + 1].visited) neighbors.push_back(1); // Right
+        if (y < height_ - 1 && !maze_[y + 1][x].visited) neighbors.push_back(2); // Bottom
+        if (x > 0 && !maze_[y][x - 1].visited) neighbors.push_back(3); // Left
+
+        if (!neighbors.empty()) {
+            std::uniform_int_distribution<> distrib_n(0, neighbors.size() - 1);
+            int next_dir = neighbors[distrib_n(gen)];
+
+            int next_x = x;
+            int next_y = y;
+
+            switch (next_dir) {
+            case 0: next_y--; maze_[y][x].walls[0] = false; maze_[next_y][next_x].walls[2] = false; break;
+            case 1: next_x++; maze_[y][x].walls[1] = false; maze_[next_y][next_x].walls[3] = false; break;
+            case 2: next_y++; maze_[y][x].walls[2] = false; maze_[next_y][next_x].walls[0] = false; break;
+            case 3: next_x--; maze_[y][x].walls[3] = false; maze_[next_y][next_x].walls[1] = false; break;
+            }
+            maze_[next_y][next_x].visited = true;
+            stack.push({ next_x, next_y });
+        }
+        else {
+            stack.pop();
+        }
+    }
+
+    maze_[0][0].walls[3] = false;
+    maze_[height_ - 1][width_ - 1].walls[1] = false;
+}
+
+// --- BENCHMARK ---
+
+double Seconds(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+void Report(const std::string& name, double seconds, size_t cells, double bytes) {
+    std::cout << "  " << std::left << std::setw(26) << name << std::right << std::fixed
+        << std::setw(10) << std::setprecision(1) << seconds * 1000.0 << " ms"
+        << std::setw(10) << std::setprecision(1) << seconds * 1e9 / cells << " ns/cell"
+        << std::setw(10) << std::setprecision(3) << bytes / cells << " bytes/cell" << std::endl;
+}
+
+// A perfect maze has exactly cells - 1 openings and no loops, which together
+// mean every cell is reachable. Union-find over the openings checks both.
+bool IsPerfect(const MazeGrid& grid) {
+    std::vector<uint32_t> parent(grid.cellCount());
+    std::iota(parent.begin(), parent.end(), 0u);
+    auto find = [&](uint32_t cell) {
+        while (parent[cell] != cell) cell = parent[cell] = parent[parent[cell]];
+        return cell;
+    };
+    size_t openings = 0;
+    for (int y = 0; y < grid.height(); ++y) {
+        for (int x = 0; x < grid.width(); ++x) {
+            uint32_t cell = static_cast<uint32_t>(grid.index(x, y));
+            uint32_t neighbors[2];
+            int count = 0;
+            if (x + 1 < grid.width() && !grid.rightWall(cell)) neighbors[count++] = cell + 1;
+            if (y + 1 < grid.height() && !grid.bottomWall(cell)) neighbors[count++] = cell + grid.width();
+            for (int n = 0; n < count; ++n) {
+                uint32_t a = find(cell), b = find(neighbors[n]);
+                if (a == b) return false; // loop
+                parent[b] = a;
+                ++openings;
+            }
+        }
+    }
+    return openings + 1 == grid.cellCount();
+}
+
+// Returns false if the two mazes differ anywhere.
+bool RunSize(int width, int height, unsigned seed) {
+    size_t cells = static_cast<size_t>(width) * height;
+    std::cout << width << "x" << height << " (" << cells << " cells)" << std::endl;
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::vector<Cell>> reference(height, std::vector<Cell>(width));
+    std::mt19937 referenceGen(seed);
+    ReferenceGenerate(reference, width, height, referenceGen);
+    double referenceTime = Seconds(t0);
+    // Cells plus one heap block and vector header per row; the DFS stack is extra
+    Report("vector<vector<Cell>>", referenceTime, cells, double(cells * sizeof(Cell) + height * (sizeof(std::vector<Cell>) + 16)));
+
+    t0 = std::chrono::steady_clock::now();
+    MazeGrid grid(width, height);
+    std::mt19937 gridGen(seed);
+    GenerateBacktracker(grid, gridGen);
+    double gridTime = Seconds(t0);
+    Report("MazeGrid (3 bits/cell)", gridTime, cells, double(grid.storageBytes()));
+    std::cout << "  speedup " << std::setprecision(2) << referenceTime / gridTime << "x" << std::endl;
+
+    size_t mismatches = 0;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            for (int side = 0; side < 4; ++side) {
+                if (reference[y][x].walls[side] != grid.hasWall(x, y, side)) ++mismatches;
+            }
+        }
+    }
+    std::cout << "  wall check: " << mismatches << " mismatches" << std::endl;
+
+    const int tile = 256;
+    unsigned threads = std::max(2u, DefaultThreadCount());
+    t0 = std::chrono::steady_clock::now();
+    MazeGrid tiledSerial(width, height);
+    GenerateTiled(tiledSerial, seed, tile, tile, 1);
+    double serialTime = Seconds(t0);
+    Report("tiled 256x256, 1 thread", serialTime, cells, double(tiledSerial.storageBytes()));
+
+    t0 = std::chrono::steady_clock::now();
+    MazeGrid tiledParallel(width, height);
+    GenerateTiled(tiledParallel, seed, tile, tile, threads);
+    double parallelTime = Seconds(t0);
+    Report("tiled 256x256, " + std::to_string(threads) + (threads == 1 ? " thread" : " threads"), parallelTime, cells, double(tiledParallel.storageBytes()));
+    std::cout << "  speedup " << std::setprecision(2) << serialTime / parallelTime << "x over 1 thread" << std::endl;
+
+    auto sameWalls = [&](const MazeGrid& other) {
+        for (size_t cell = 0; cell < tiledSerial.cellCount(); ++cell) {
+            if (tiledSerial.rightWall(cell) != other.rightWall(cell) || tiledSerial.bottomWall(cell) != other.bottomWall(cell)) return false;
+        }
+        return true;
+    };
+    bool same = sameWalls(tiledParallel);
+    std::string counts = "1, " + std::to_string(threads);
+    for (unsigned fixed : { 3u, 8u }) {
+        if (fixed == threads) continue;
+        MazeGrid tiledFixed(width, height);
+        GenerateTiled(tiledFixed, seed, tile, tile, fixed);
+        same = sameWalls(tiledFixed) && same;
+        counts += ", " + std::to_string(fixed);
+    }
+    bool perfect = IsPerfect(tiledParallel);
+    std::cout << "  tiled check: " << (same ? "same" : "DIFFERENT") << " on " << counts << " threads, "
+        << (perfect ? "perfect" : "NOT PERFECT") << std::endl;
+    return mismatches == 0 && same && perfect;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::pair<int, int>> sizes;
+    for (int i = 1; i < argc; ++i) {
+        int w, h;
+        if (std::sscanf(argv[i], "%dx%d", &w, &h) != 2 || w < 1 || h < 1) {
+            std::cerr << "Usage: " << argv[0] << " [<cols>x<rows> ...]" << std::endl;
+            return 1;
+        }
+        sizes.push_back({ w, h });
+    }
+    if (sizes.empty()) sizes = { { 50, 70 }, { 1000, 1000 }, { 4000, 4000 } };
+
+    bool ok = true;
+    for (const auto& size : sizes) ok = RunSize(size.first, size.second, 12345) && ok;
+    return ok ? 0 : 1;
+}
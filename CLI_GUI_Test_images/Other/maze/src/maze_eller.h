@@ -0,0 +1,128 @@
+// FILE: maze_eller.h
+// PURPOSE: Row-at-a-time maze generation with Eller's algorithm. Only the
+//          current row is kept (which connected set each cell belongs to),
+//          so a maze of any length can be carved and printed in constant
+//          memory, one row after another.
+//
+//          Each row: cells not yet joined from above start sets of their
+//          own; neighbours in different sets are joined at random (merging
+//          the sets); then every set opens at least one cell downwards so it
+//          reaches the next row. The final row joins every remaining set,
+//          which makes the maze perfect: exactly one path between any two
+//          cells.
+//
+//          Walls use the same convention as MazeGrid: each cell owns its
+//          right and bottom walls, and the border is closed except for the
+//          entry (left of the first row's first cell) and the exit (right of
+//          the last row's last cell).
+//
+// AUTHOR: hamslices
+//
+// USAGE: EllerMaze eller(50, gen);
+//        MazeRow row;
+//        for (int y = 0; y < rows; ++y) {
+//            eller.nextRow(y == rows - 1, row);
+//            ... row.right[x], row.bottom[x] ...
+//        }
+
+#pragma once
+
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <numeric>
+#include <algorithm>
+
+// One carved row. 1 = wall. 'bottom' is the top wall of the next row.
+struct MazeRow {
+    std::vector<uint8_t> right;
+    std::vector<uint8_t> bottom;
+};
+
+template <typename Rng>
+class EllerMaze {
+public:
+    EllerMaze(int width, Rng& gen)
+        : width_(width), gen_(gen), set_(width, -1), parent_(width), relabel_(width),
+          members_(width), pick_(width), hasDown_(width) {}
+
+    int width() const { return width_; }
+
+    // Carves the next row into 'row'. Pass last = true for the final row.
+    void nextRow(bool last, MazeRow& row) {
+        row.right.assign(width_, 1);
+        row.bottom.assign(width_, 1);
+
+        // A set carried down from the row above is relabelled with the index
+        // of its first cell here; a new cell is labelled with its own index.
+        // Labels stay unique and never exceed the row width.
+        std::fill(relabel_.begin(), relabel_.end(), -1);
+        for (int x = 0; x < width_; ++x) {
+            if (set_[x] >= 0) {
+                int& label = relabel_[set_[x]];
+                if (label < 0) label = x;
+                set_[x] = label;
+            }
+            else {
+                set_[x] = x;
+            }
+        }
+        std::iota(parent_.begin(), parent_.end(), 0);
+
+        // Join neighbours from different sets at random (all of them on the last row)
+        std::bernoulli_distribution coin(0.5);
+        for (int x = 0; x + 1 < width_; ++x) {
+            int a = setOf(x), b = setOf(x + 1);
+            if (a != b && (last || coin(gen_))) {
+                row.right[x] = 0;
+                parent_[b] = a;
+            }
+        }
+        if (last) {
+            row.right[width_ - 1] = 0; // exit
+            return;
+        }
+
+        // Every set needs at least one way down: each cell opens with even
+        // odds, and a set that got none opens one of its cells picked at
+        // random (a running reservoir pick over its members).
+        std::fill(members_.begin(), members_.end(), 0);
+        std::fill(hasDown_.begin(), hasDown_.end(), 0);
+        for (int x = 0; x < width_; ++x) {
+            int root = setOf(x);
+            if (coin(gen_)) {
+                row.bottom[x] = 0;
+                hasDown_[root] = 1;
+            }
+            ++members_[root];
+            if (std::uniform_int_distribution<int>(0, members_[root] - 1)(gen_) == 0) pick_[root] = x;
+        }
+        for (int root = 0; root < width_; ++root) {
+            if (members_[root] > 0 && !hasDown_[root]) row.bottom[pick_[root]] = 0;
+        }
+
+        // Cells that open downwards carry their set into the next row
+        for (int x = 0; x < width_; ++x) {
+            set_[x] = row.bottom[x] == 0 ? setOf(x) : -1;
+        }
+    }
+
+private:
+    int find(int label) {
+        while (parent_[label] != label) {
+            parent_[label] = parent_[parent_[label]];
+            label = parent_[label];
+        }
+        return label;
+    }
+    int setOf(int x) { return find(set_[x]); }
+
+    int width_;
+    Rng& gen_;
+    std::vector<int> set_;      // label of each cell's set, -1 if not joined from above
+    std::vector<int> parent_;   // union-find over this row's labels
+    std::vector<int> relabel_;
+    std::vector<int> members_;
+    std::vector<int> pick_;
+    std::vector<uint8_t> hasDown_;
+};
@@ -1,109 +1,175 @@
 // FILE: maze_generator.cpp
-// PURPOSE: creates a maze on an 8.5x11" (1728x2236) canvas
+// PURPOSE: creates a maze on an 8.5x11" (1728x2236) canvas, or a longer one
+//          (--height), or streams one of any length to the printer a row at
+//          a time (--stream). Pages are drawn and written a band at a time;
+//          --solve adds an answer sheet with the solution drawn in.
 //
 // AUTHOR: hamslices
 // ASSISTANCE: Major portions of this code were developed in collaboration with Google's AI.
 //
-// USAGE: ./maze_generator
+// REQUIRES: maze_grid.h, maze_eller.h and maze_solver.h in the same directory;
+//           lark_bitmap.h, lark_raster.h, lark_image_writer.h and lark_parallel.h
+//           in ../../common.
+// USAGE: ./maze_generator [--size <cols>x<rows>] [--format pgm|pbm|png] [--height <dots>]
+//            [--seed <n>] [--tile <cols>x<rows> [--threads <n>]] [--solve bfs|astar]
+//        ./maze_generator --stream [--size <cols>x<rows>] [--output <file>|-] [--seed <n>]
 
 #include <iostream>
 #include <vector>
-#include <stack>
 #include <random>
 #include <fstream>
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
 
-// Represents a single cell in the maze
-struct Cell {
-    bool visited = false;
-    bool walls[4] = { true, true, true, true }; // Top, Right, Bottom, Left
-};
+#include "../../common/lark_bitmap.h"
+#include "../../common/lark_raster.h"
+#include "../../common/lark_image_writer.h"
+#include "maze_grid.h"
+#include "maze_eller.h"
+#include "maze_solver.h"
 
-class Maze {
-public:
-    Maze(int width, int height) : width_(width), height_(height) {
-        maze_.resize(height_, std::vector<Cell>(width_));
-    }
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+// Solution line: dark gray on screen, black on a 1-bit print.
+const unsigned char PATH_COLOR = 96;
 
-    void generate() {
-        std::stack<std::pair<int, int>> stack;
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<> distrib_w(0, width_ - 1);
-        std::uniform_int_distribution<> distrib_h(0, height_ - 1);
-
-        int start_x = distrib_w(gen);
-        int start_y = distrib_h(gen);
-
-        maze_[start_y][start_x].visited = true;
-        stack.push({ start_x, start_y });
-
-        while (!stack.empty()) {
-            std::pair<int, int> current = stack.top();
-            int x = current.first;
-            int y = current.second;
-
-            std::vector<int> neighbors;
-            if (y > 0 && !maze_[y - 1][x].visited) neighbors.push_back(0); // Top
-            if (x < width_ - 1 && !maze_[y][x + 1].visited) neighbors.push_back(1); // Right
-            if (y < height_ - 1 && !maze_[y + 1][x].visited) neighbors.push_back(2); // Bottom
-            if (x > 0 && !maze_[y][x - 1].visited) neighbors.push_back(3); // Left
-
-            if (!neighbors.empty()) {
-                std::uniform_int_distribution<> distrib_n(0, neighbors.size() - 1);
-                int next_dir = neighbors[distrib_n(gen)];
-
-                int next_x = x;
-                int next_y = y;
-
-                switch (next_dir) {
-                case 0: // Top
-                    next_y--;
-                    maze_[y][x].walls[0] = false;
-                    maze_[next_y][next_x].walls[2] = false;
-                    break;
-                case 1: // Right
-                    next_x++;
-                    maze_[y][x].walls[1] = false;
-                    maze_[next_y][next_x].walls[3] = false;
-                    break;
-                case 2: // Bottom
-                    next_y++;
-                    maze_[y][x].walls[2] = false;
-                    maze_[next_y][next_x].walls[0] = false;
-                    break;
-                case 3: // Left
-                    next_x--;
-                    maze_[y][x].walls[3] = false;
-                    maze_[next_y][next_x].walls[1] = false;
-                    break;
+// Draws one row of cells into the rows of it that fall in the band. Each
+// cell's walls are drawn inside the cell, wall_thickness dots thick, so a
+// wall between two cells shows as both halves. walls(x, side) says whether
+// cell x has a wall on that side; path_sides(x) is a mask of the sides
+// (1 << WALL_TOP ...) the solution leaves cell x by, 0 off the path. The
+// path is drawn path_thickness dots wide through the cell centres.
+//
+// A cell row only has a few kinds of scanline: the top wall rows, the
+// bottom wall rows and the rows between, which cross just the vertical
+// walls, each split where the path crosses the middle of the cells. Each
+// kind is drawn once per band, as runs of merged neighbouring walls, and
+// copied to the other rows of that kind.
+template <typename Bitmap, typename Walls, typename PathSides>
+void DrawCellRow(Bitmap& band, int x_offset, int start_y, int columns, int cell_width_px, int cell_height_px,
+    int wall_thickness, Walls walls, int path_thickness, PathSides path_sides) {
+    int y0 = std::max(start_y, band.top);
+    int y1 = std::min(start_y + cell_height_px, band.top + band.height);
+    int path_top = (cell_height_px - path_thickness) / 2, path_left = (cell_width_px - path_thickness) / 2;
+    int drawn_kind = -1, drawn_y = 0;
+    for (int y = y0; y < y1; ++y) {
+        int r = y - start_y;
+        int path_kind = path_thickness == 0 ? 0 : r < path_top ? 1 : r < path_top + path_thickness ? 2 : 3;
+        int kind = (r < wall_thickness ? 1 : 0) | (r >= cell_height_px - wall_thickness ? 2 : 0) | path_kind << 2;
+        if (kind == drawn_kind) {
+            std::memcpy(band.Row(y), band.Row(drawn_y), band.Stride());
+            continue;
+        }
+        {
+            ScanlineRuns<Bitmap> runs(band, y, 0);
+            for (int x = 0; x < columns; ++x) {
+                int start_x = x * cell_width_px + x_offset;
+                if (((kind & 1) && walls(x, WALL_TOP)) || ((kind & 2) && walls(x, WALL_BOTTOM))) {
+                    runs.add(start_x, start_x + cell_width_px);
+                    continue;
                 }
-                maze_[next_y][next_x].visited = true;
-                stack.push({ next_x, next_y });
+                if (walls(x, WALL_LEFT)) runs.add(start_x, start_x + wall_thickness);
+                if (walls(x, WALL_RIGHT)) runs.add(start_x + cell_width_px - wall_thickness, start_x + cell_width_px);
             }
-            else {
-                stack.pop();
+        }
+        if (path_kind != 0) {
+            ScanlineRuns<Bitmap> runs(band, y, PATH_COLOR);
+            for (int x = 0; x < columns; ++x) {
+                int sides = path_sides(x);
+                if (sides == 0) continue;
+                int start_x = x * cell_width_px + x_offset;
+                int mid_x = start_x + path_left;
+                if (path_kind == 2) {
+                    runs.add((sides & (1 << WALL_LEFT)) ? start_x : mid_x,
+                        (sides & (1 << WALL_RIGHT)) ? start_x + cell_width_px : mid_x + path_thickness);
+                }
+                else if (sides & (1 << (path_kind == 1 ? WALL_TOP : WALL_BOTTOM))) {
+                    runs.add(mid_x, mid_x + path_thickness);
+                }
             }
         }
-
-        // Create an entry and exit
-        maze_[0][0].walls[3] = false; // Entry on the left of the top-left cell
-        maze_[height_ - 1][width_ - 1].walls[1] = false; // Exit on the right of the bottom-right cell
+        drawn_kind = kind;
+        drawn_y = y;
     }
+}
 
-    void saveToPgm(const std::string& filename, int image_width, int image_height) const {
-        std::ofstream outfile(filename, std::ios::out | std::ios::binary);
-        if (!outfile) {
-            std::cerr << "Error opening file for writing: " << filename << std::endl;
-            return;
+template <typename Bitmap, typename Walls>
+void DrawCellRow(Bitmap& band, int x_offset, int start_y, int columns, int cell_width_px, int cell_height_px,
+    int wall_thickness, Walls walls) {
+    DrawCellRow(band, x_offset, start_y, columns, cell_width_px, cell_height_px, wall_thickness, walls,
+        0, [](int) { return 0; });
+}
+
+class Maze {
+public:
+    Maze(int width, int height) : width_(width), height_(height), grid_(width, height) {}
+
+    // tile_width == 0 carves the whole maze in one pass; otherwise it is
+    // carved in tiles of that many cells on 'threads' workers.
+    void generate(uint32_t seed, int tile_width, int tile_height, unsigned threads) {
+        if (tile_width > 0) {
+            GenerateTiled(grid_, seed, tile_width, tile_height, threads);
         }
+        else {
+            std::mt19937 gen(seed);
+            GenerateBacktracker(grid_, gen);
+        }
+        grid_.releaseVisited();
+    }
 
-        // The PGM canvas size remains the same
-        outfile << "P5\n" << image_width << " " << image_height << "\n255\n";
+    // Finds the way from the entry to the exit; save() then draws it over
+    // the maze when asked to.
+    const MazeSolution& solve(SolverKind kind) {
+        solution_ = SolveMaze(grid_, kind);
+        pathSides_.assign(grid_.cellCount(), 0);
+        const std::vector<uint32_t>& path = solution_.path;
+        if (path.empty()) return solution_;
+        pathSides_[path.front()] |= 1 << WALL_LEFT;  // in through the entry
+        pathSides_[path.back()] |= 1 << WALL_RIGHT;  // out through the exit
+        for (size_t i = 1; i < path.size(); ++i) {
+            uint32_t a = path[i - 1], b = path[i];
+            int side = b == a + 1 ? WALL_RIGHT : b + 1 == a ? WALL_LEFT : b > a ? WALL_BOTTOM : WALL_TOP;
+            pathSides_[a] |= static_cast<uint8_t>(1 << side);
+            pathSides_[b] |= static_cast<uint8_t>(1 << OppositeSide(side));
+        }
+        return solution_;
+    }
 
-        // Background is initialized to white (255)
-        std::vector<unsigned char> pixel_data(image_width * image_height, 255);
+    // Draws the maze centred on the canvas and writes it one band at a time,
+    // so only band_height rows of canvas are ever held.
+    bool save(const std::string& filename, ImageFormat format, int image_width, int image_height, int band_height,
+        bool with_solution = false) const {
+        ImageWriter writer;
+        if (!writer.open(filename, format, image_width, image_height)) {
+            std::cerr << "Error opening file for writing: " << filename << std::endl;
+            return false;
+        }
+        auto emit = [&](const auto& band) { writer.writeBand(band); };
+        if (ImageFormatIsMono(format)) {
+            renderBands<MonoBitmap>(image_width, image_height, band_height, with_solution, emit);
+        }
+        else {
+            renderBands<GrayBitmap>(image_width, image_height, band_height, with_solution, emit);
+        }
+        if (!writer.close()) {
+            std::cerr << "Error: Failed while writing " << filename << std::endl;
+            return false;
+        }
+        return true;
+    }
 
+private:
+    // Renders the canvas top to bottom, black walls on white, handing each
+    // finished band to emit(). The last band may be shorter than band_height.
+    template <typename Bitmap, typename EmitBand>
+    void renderBands(int image_width, int image_height, int band_height, bool with_solution, EmitBand emit) const {
         const int shrink_pixels = 50;
         const int x_offset = shrink_pixels / 2;
         const int y_offset = shrink_pixels / 2;
@@ -116,68 +182,191 @@ public:
         int cell_height_px = maze_render_height / height_;
 
         int wall_thickness = std::max(1, std::min(cell_width_px, cell_height_px) / 5);
+        int path_thickness = with_solution && !pathSides_.empty() ? wall_thickness : 0;
 
-        for (int y = 0; y < height_; ++y) {
-            for (int x = 0; x < width_; ++x) {
-                // Apply the offset to the starting coordinates of each cell
-                int start_x = x * cell_width_px + x_offset;
-                int start_y = y * cell_height_px + y_offset;
-
-                if (maze_[y][x].walls[0]) { // Top wall
-                    for (int i = 0; i < cell_width_px; ++i) {
-                        for (int t = 0; t < wall_thickness; ++t) {
-                            if (start_y + t < image_height && start_x + i < image_width)
-                                pixel_data[(start_y + t) * image_width + start_x + i] = 0;
-                        }
-                    }
-                }
-                if (maze_[y][x].walls[1]) { // Right wall
-                    for (int i = 0; i < cell_height_px; ++i) {
-                        for (int t = 0; t < wall_thickness; ++t) {
-                            if (start_y + i < image_height && start_x + cell_width_px - t - 1 < image_width)
-                                pixel_data[(start_y + i) * image_width + start_x + cell_width_px - t - 1] = 0;
-                        }
-                    }
-                }
-                if (maze_[y][x].walls[2]) { // Bottom wall
-                    for (int i = 0; i < cell_width_px; ++i) {
-                        for (int t = 0; t < wall_thickness; ++t) {
-                            if (start_y + cell_height_px - t - 1 < image_height && start_x + i < image_width)
-                                pixel_data[(start_y + cell_height_px - t - 1) * image_width + start_x + i] = 0;
-                        }
-                    }
-                }
-                if (maze_[y][x].walls[3]) { // Left wall
-                    for (int i = 0; i < cell_height_px; ++i) {
-                        for (int t = 0; t < wall_thickness; ++t) {
-                            if (start_y + i < image_height && start_x + t < image_width)
-                                pixel_data[(start_y + i) * image_width + start_x + t] = 0;
-                        }
-                    }
-                }
+        Bitmap band(image_width, band_height);
+        for (int top = 0; top < image_height; top += band_height) {
+            int rows = std::min(band_height, image_height - top);
+            if (rows != band.height) band = Bitmap(image_width, rows);
+            band.top = top;
+            band.Clear(255);
+            // Only the cell rows that reach into this band
+            int first = std::max(0, (top - y_offset) / cell_height_px);
+            int last = std::min(height_ - 1, (top + rows - 1 - y_offset) / cell_height_px);
+            for (int y = first; y <= last && top + rows > y_offset; ++y) {
+                DrawCellRow(band, x_offset, y * cell_height_px + y_offset, width_, cell_width_px, cell_height_px,
+                    wall_thickness, [&](int x, int side) { return grid_.hasWall(x, y, side); },
+                    path_thickness, [&](int x) { return pathSides_[grid_.index(x, y)]; });
             }
+            emit(band);
         }
-        outfile.write(reinterpret_cast<const char*>(pixel_data.data()), pixel_data.size());
     }
 
-private:
     int width_;
     int height_;
-    std::vector<std::vector<Cell>> maze_;
+    MazeGrid grid_;
+    MazeSolution solution_;
+    std::vector<uint8_t> pathSides_; // per cell, the sides the solution leaves by
 };
 
-int main() {
-    const int MAZE_WIDTH = 50;
-    const int MAZE_HEIGHT = 70;
+// Carves a maze with Eller's algorithm one row at a time and writes each row
+// out as soon as it is done, as headerless 1-bit print rows (216 bytes per
+// 1728-dot row). Nothing but the current row is kept, so rows == 0 streams an
+// endless maze. Cells are square and fill the print width.
+int StreamMaze(int columns, int rows, int image_width, uint32_t seed, const std::string& filename) {
+    const int margin = 25;
+    int cell_px = (image_width - 2 * margin) / columns;
+    if (cell_px < 1) {
+        std::cerr << "Error: " << columns << " columns do not fit in " << image_width << " dots." << std::endl;
+        return 1;
+    }
+    int wall_thickness = std::max(1, cell_px / 5);
+
+    std::ofstream outfile;
+    std::ostream* out = &std::cout;
+    if (filename != "-") {
+        outfile.open(filename, std::ios::out | std::ios::binary);
+        if (!outfile) {
+            std::cerr << "Error opening file for writing: " << filename << std::endl;
+            return 1;
+        }
+        out = &outfile;
+    }
+#ifdef _WIN32
+    else {
+        _setmode(_fileno(stdout), _O_BINARY);
+    }
+#endif
+    long long rows_written = 0;
+    auto emit = [&](const MonoBitmap& band) {
+        out->write(reinterpret_cast<const char*>(band.bits.data()), band.bits.size());
+        out->flush();
+        rows_written += band.height;
+    };
+
+    std::mt19937 gen(seed);
+    EllerMaze<std::mt19937> eller(columns, gen);
+    MazeRow row, above;
+    MonoBitmap band(image_width, cell_px);
+    emit(MonoBitmap(image_width, margin));
+    for (long long y = 0; rows == 0 || y < rows; ++y) {
+        eller.nextRow(rows > 0 && y == rows - 1, row);
+        band.Clear(255); // the band is one cell high, starting at row 0
+        DrawCellRow(band, margin, 0, columns, cell_px, cell_px, wall_thickness, [&](int x, int side) {
+            switch (side) {
+            case WALL_TOP: return y == 0 || above.bottom[x] != 0;
+            case WALL_RIGHT: return row.right[x] != 0;
+            case WALL_BOTTOM: return row.bottom[x] != 0;
+            default: return x == 0 ? y != 0 : row.right[x - 1] != 0;
+            }
+        });
+        emit(band);
+        std::swap(above, row);
+        if (!*out) break; // reader went away
+    }
+    emit(MonoBitmap(image_width, margin));
+    std::cerr << "Wrote " << rows_written << " rows of " << image_width << " dots." << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
     const int IMAGE_WIDTH = 1728;
-    const int IMAGE_HEIGHT = 2236;
-    const std::string FILENAME = "maze_centered.pgm";
+    const int BAND_HEIGHT = 256;
+    int image_height = 2236; // 11"; 4472 and 6708 make the 22" and 33" samples
+
+    int maze_width = 50;
+    int maze_height = 70;
+    ImageFormat format = ImageFormat::Pgm;
+    bool stream = false;
+    std::string output = "maze_stream.raw";
+    uint32_t seed = std::random_device()();
+    int tile_width = 0, tile_height = 0;
+    unsigned threads = DefaultThreadCount();
+    bool solve = false;
+    SolverKind solver = SolverKind::Bfs;
+    bool args_ok = true;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc) {
+            args_ok = ParseImageFormat(argv[++i], format);
+        }
+        else if (arg == "--height" && i + 1 < argc) {
+            image_height = std::atoi(argv[++i]);
+        }
+        else if (arg == "--stream") {
+            stream = true;
+        }
+        else if (arg == "--output" && i + 1 < argc) {
+            output = argv[++i];
+        }
+        else if (arg == "--size" && i + 1 < argc) {
+            args_ok = std::sscanf(argv[++i], "%dx%d", &maze_width, &maze_height) == 2;
+        }
+        else if (arg == "--seed" && i + 1 < argc) {
+            seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (arg == "--tile" && i + 1 < argc) {
+            args_ok = std::sscanf(argv[++i], "%dx%d", &tile_width, &tile_height) == 2 && tile_width > 0 && tile_height > 0;
+        }
+        else if (arg == "--solve" && i + 1 < argc) {
+            std::string name = argv[++i];
+            solve = true;
+            args_ok = name == "bfs" || name == "astar";
+            solver = name == "astar" ? SolverKind::AStar : SolverKind::Bfs;
+        }
+        else if (arg == "--threads" && i + 1 < argc) {
+            int n = std::atoi(argv[++i]);
+            threads = n > 0 ? static_cast<unsigned>(n) : DefaultThreadCount();
+        }
+        else {
+            args_ok = false;
+        }
+    }
+    // Cells are numbered with 32 bits while carving a whole maze, and every
+    // cell needs at least a dot on the page
+    if (!args_ok || maze_width < 1 || maze_height < (stream ? 0 : 1) ||
+        (!stream && (static_cast<unsigned long long>(maze_width) * maze_height > 0xFFFFFFFFull ||
+            maze_width > IMAGE_WIDTH - 50 || image_height - 50 < maze_height))) {
+        std::cerr << "Usage: " << argv[0] << " [--size <cols>x<rows>] [--format pgm|pbm|png] [--height <dots>]" << std::endl;
+        std::cerr << "           [--seed <n>] [--tile <cols>x<rows> [--threads <n>]] [--solve bfs|astar]" << std::endl;
+        std::cerr << "       " << argv[0] << " --stream [--size <cols>x<rows>] [--output <file>|-] [--seed <n>]" << std::endl;
+        std::cerr << "  --size     Maze cells across and down (default 50x70)" << std::endl;
+        std::cerr << "  --format   pgm: 8-bit grayscale (default), pbm: packed 1 bit per dot, png: 1-bit PNG" << std::endl;
+        std::cerr << "  --height   Canvas height in dots (default 2236, 11\" at 203 dpi)" << std::endl;
+        std::cerr << "  --seed     Same seed, same maze (default random; the seed used is printed)" << std::endl;
+        std::cerr << "  --tile     Carve in tiles of this many cells in parallel, then join them" << std::endl;
+        std::cerr << "  --threads  Workers for --tile (0 = one per core, default); the maze" << std::endl;
+        std::cerr << "             does not depend on it" << std::endl;
+        std::cerr << "  --solve    Also write the answer sheet, maze_solution.<ext>, with the path drawn in" << std::endl;
+        std::cerr << "  --stream   Carve and print one row at a time as raw 1-bit print rows" << std::endl;
+        std::cerr << "             (default output maze_stream.raw); rows 0 never ends" << std::endl;
+        return 1;
+    }
+    std::cerr << "Seed: " << seed << std::endl;
+    if (stream) {
+        return StreamMaze(maze_width, maze_height, IMAGE_WIDTH, seed, output);
+    }
+    const std::string FILENAME = std::string("maze_centered.") + ImageFormatExtension(format);
 
-    Maze maze(MAZE_WIDTH, MAZE_HEIGHT);
-    maze.generate();
-    maze.saveToPgm(FILENAME, IMAGE_WIDTH, IMAGE_HEIGHT);
+    Maze maze(maze_width, maze_height);
+    maze.generate(seed, tile_width, tile_height, threads);
+    if (!maze.save(FILENAME, format, IMAGE_WIDTH, image_height, BAND_HEIGHT)) return 1;
 
     std::cout << "Centered maze generated and saved to " << FILENAME << std::endl;
 
+    if (solve) {
+        auto start = std::chrono::steady_clock::now();
+        const MazeSolution& solution = maze.solve(solver);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (solution.path.empty()) {
+            std::cerr << "Error: No way through the maze." << std::endl;
+            return 1;
+        }
+        const std::string SOLUTION_FILENAME = std::string("maze_solution.") + ImageFormatExtension(format);
+        if (!maze.save(SOLUTION_FILENAME, format, IMAGE_WIDTH, image_height, BAND_HEIGHT, true)) return 1;
+        std::cout << "Solved in " << ms << " ms (" << solution.path.size() << " cells on the path, "
+            << solution.visited << " searched); answer sheet saved to " << SOLUTION_FILENAME << std::endl;
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,228 @@
+// FILE: maze_grid.h
+// PURPOSE: Compact maze storage and the depth-first (recursive backtracker)
+//          generator used by maze_generator.
+//
+//          Every interior wall is shared by two cells, so each cell only
+//          stores its right and bottom walls: 2 bits, four cells per byte,
+//          in one flat row-major array. The top and left walls are read from
+//          the neighbour; the outer border is implied (closed except for the
+//          entry on the left of the top-left cell and the exit on the right
+//          of the bottom-right cell). The visited flags used while carving
+//          are a separate bitset. Together that is 3 bits per cell, so a
+//          maze of tens of millions of cells fits in a few megabytes.
+//
+//          Large mazes can be carved in tiles on several threads
+//          (GenerateTiled): each tile is a perfect maze of its own, and the
+//          tiles are then joined along a random spanning tree of the tile
+//          grid with one passage per tree edge, so the whole maze is still
+//          perfect. Every tile draws from its own generator seeded from the
+//          maze seed and the tile number, so a seed gives the same maze on
+//          any number of threads.
+//
+// AUTHOR: hamslices
+//
+// REQUIRES: lark_parallel.h in ../../common.
+// USAGE: MazeGrid grid(50, 70);
+//        std::mt19937 gen(seed);
+//        GenerateBacktracker(grid, gen);
+//        if (grid.hasWall(x, y, WALL_RIGHT)) { ... }
+//
+//        GenerateTiled(grid, seed, 256, 256, DefaultThreadCount());
+
+#pragma once
+
+#include <vector>
+#include <random>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+#include "../../common/lark_parallel.h"
+
+enum WallSide { WALL_TOP = 0, WALL_RIGHT = 1, WALL_BOTTOM = 2, WALL_LEFT = 3 };
+
+class MazeGrid {
+public:
+    MazeGrid(int width, int height)
+        : width_(width), height_(height),
+          walls_((cellCount() + 3) / 4, 0xFF),
+          visited_((cellCount() + 63) / 64, 0) {}
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    size_t cellCount() const { return static_cast<size_t>(width_) * height_; }
+    size_t index(int x, int y) const { return static_cast<size_t>(y) * width_ + x; }
+
+    // Storage only: the two walls a cell owns
+    bool rightWall(size_t cell) const { return (walls_[cell >> 2] >> ((cell & 3) * 2)) & 1; }
+    bool bottomWall(size_t cell) const { return (walls_[cell >> 2] >> ((cell & 3) * 2 + 1)) & 1; }
+
+    bool hasWall(int x, int y, int side) const {
+        switch (side) {
+        case WALL_TOP: return y == 0 || bottomWall(index(x, y - 1));
+        case WALL_RIGHT: return rightWall(index(x, y));
+        case WALL_BOTTOM: return bottomWall(index(x, y));
+        default: return x == 0 ? y != 0 : rightWall(index(x - 1, y)); // (0,0) is the entry
+        }
+    }
+
+    void openRight(size_t cell) { walls_[cell >> 2] &= static_cast<uint8_t>(~(1u << ((cell & 3) * 2))); }
+    void openBottom(size_t cell) { walls_[cell >> 2] &= static_cast<uint8_t>(~(2u << ((cell & 3) * 2))); }
+
+    // Opens every wall here that is open in 'from', for 'count' cells in a
+    // row starting at 'cell' (and at 'fromCell' in 'from'), a byte at a time.
+    void openFrom(size_t cell, const MazeGrid& from, size_t fromCell, size_t count) {
+        size_t bit = cell * 2, fromBit = fromCell * 2, bits = count * 2;
+        while (bits > 0) {
+            size_t byte = bit >> 3, fromByte = fromBit >> 3;
+            int offset = bit & 7, fromOffset = fromBit & 7;
+            int n = static_cast<int>(std::min<size_t>(8 - offset, bits));
+            unsigned source = from.walls_[fromByte] >> fromOffset;
+            if (fromOffset && fromByte + 1 < from.walls_.size()) source |= from.walls_[fromByte + 1] << (8 - fromOffset);
+            unsigned mask = ((1u << n) - 1) << offset;
+            walls_[byte] &= static_cast<uint8_t>((source << offset) | ~mask);
+            bit += n;
+            fromBit += n;
+            bits -= n;
+        }
+    }
+
+    bool visited(size_t cell) const { return (visited_[cell >> 6] >> (cell & 63)) & 1; }
+    void markVisited(size_t cell) { visited_[cell >> 6] |= uint64_t(1) << (cell & 63); }
+
+    // The visited flags are only needed while carving
+    void releaseVisited() { std::vector<uint64_t>().swap(visited_); }
+
+    size_t storageBytes() const { return walls_.size() + visited_.size() * sizeof(uint64_t); }
+
+private:
+    int width_;
+    int height_;
+    std::vector<uint8_t> walls_;
+    std::vector<uint64_t> visited_;
+};
+
+// Carves a perfect maze with the recursive backtracker, starting from a
+// random cell. Given the same generator state it draws the same random
+// numbers in the same order as the original vector<vector<Cell>> version,
+// so seeded mazes are unchanged. The border is left closed.
+template <typename Rng>
+void CarveBacktracker(MazeGrid& grid, Rng& gen) {
+    const int width = grid.width(), height = grid.height();
+    std::uniform_int_distribution<> distrib_w(0, width - 1);
+    std::uniform_int_distribution<> distrib_h(0, height - 1);
+    int start_x = distrib_w(gen);
+    int start_y = distrib_h(gen);
+
+    // Cells are packed as y * width + x; the stack can reach every cell
+    std::vector<uint32_t> stack;
+    stack.reserve(1024);
+    uint32_t start = static_cast<uint32_t>(grid.index(start_x, start_y));
+    grid.markVisited(start);
+    stack.push_back(start);
+
+    while (!stack.empty()) {
+        uint32_t current = stack.back();
+        int x = static_cast<int>(current % width);
+        int y = static_cast<int>(current / width);
+
+        int neighbors[4];
+        int count = 0;
+        if (y > 0 && !grid.visited(current - width)) neighbors[count++] = WALL_TOP;
+        if (x < width - 1 && !grid.visited(current + 1)) neighbors[count++] = WALL_RIGHT;
+        if (y < height - 1 && !grid.visited(current + width)) neighbors[count++] = WALL_BOTTOM;
+        if (x > 0 && !grid.visited(current - 1)) neighbors[count++] = WALL_LEFT;
+
+        if (count == 0) {
+            stack.pop_back();
+            continue;
+        }
+        std::uniform_int_distribution<> distrib_n(0, count - 1);
+        uint32_t next = current;
+        switch (neighbors[distrib_n(gen)]) {
+        case WALL_TOP:
+            next = current - width;
+            grid.openBottom(next);
+            break;
+        case WALL_RIGHT:
+            next = current + 1;
+            grid.openRight(current);
+            break;
+        case WALL_BOTTOM:
+            next = current + width;
+            grid.openBottom(current);
+            break;
+        case WALL_LEFT:
+            next = current - 1;
+            grid.openRight(next);
+            break;
+        }
+        grid.markVisited(next);
+        stack.push_back(next);
+    }
+}
+
+// The whole maze in one pass, with the exit on the right of the
+// bottom-right cell.
+template <typename Rng>
+void GenerateBacktracker(MazeGrid& grid, Rng& gen) {
+    CarveBacktracker(grid, gen);
+    grid.openRight(grid.index(grid.width() - 1, grid.height() - 1)); // exit
+}
+
+// Carves the maze in tiles of tile_width x tile_height cells (the last row
+// and column of tiles may be smaller) on 'threads' workers, then joins them.
+// The result depends only on the seed and the tile size.
+inline void GenerateTiled(MazeGrid& grid, uint32_t seed, int tile_width, int tile_height, unsigned threads) {
+    const int width = grid.width(), height = grid.height();
+    tile_width = std::min(tile_width, width);
+    tile_height = std::min(tile_height, height);
+    const int tiles_x = (width + tile_width - 1) / tile_width;
+    const int tiles_y = (height + tile_height - 1) / tile_height;
+    const size_t tile_count = static_cast<size_t>(tiles_x) * tiles_y;
+
+    // Workers carve into tiles of their own; the calling thread copies them
+    // in, since neighbouring tiles can share bytes of the packed grid.
+    size_t window = 2 * static_cast<size_t>(std::max(1u, threads));
+    std::vector<MazeGrid> slots(std::min(window, tile_count), MazeGrid(0, 0));
+    auto tileX = [&](size_t i) { return static_cast<int>(i % tiles_x) * tile_width; };
+    auto tileY = [&](size_t i) { return static_cast<int>(i / tiles_x) * tile_height; };
+
+    ParallelOrdered(tile_count, threads, window,
+        [&](size_t i) {
+            MazeGrid& tile = slots[i % slots.size()];
+            tile = MazeGrid(std::min(tile_width, width - tileX(i)), std::min(tile_height, height - tileY(i)));
+            std::seed_seq seq{ seed, static_cast<uint32_t>(i) };
+            std::mt19937 gen(seq);
+            CarveBacktracker(tile, gen);
+        },
+        [&](size_t i) {
+            const MazeGrid& tile = slots[i % slots.size()];
+            for (int y = 0; y < tile.height(); ++y) {
+                grid.openFrom(grid.index(tileX(i), tileY(i) + y), tile, tile.index(0, y), tile.width());
+            }
+        });
+
+    // A perfect maze over the tiles is a spanning tree of the tile grid:
+    // open one passage at a random place along each edge it uses.
+    std::seed_seq seq{ seed, static_cast<uint32_t>(tile_count) };
+    std::mt19937 gen(seq);
+    MazeGrid tree(tiles_x, tiles_y);
+    CarveBacktracker(tree, gen);
+    for (int ty = 0; ty < tiles_y; ++ty) {
+        for (int tx = 0; tx < tiles_x; ++tx) {
+            int x0 = tx * tile_width, y0 = ty * tile_height;
+            int x1 = std::min(x0 + tile_width, width), y1 = std::min(y0 + tile_height, height);
+            if (tx + 1 < tiles_x && !tree.rightWall(tree.index(tx, ty))) {
+                int y = std::uniform_int_distribution<>(y0, y1 - 1)(gen);
+                grid.openRight(grid.index(x1 - 1, y));
+            }
+            if (ty + 1 < tiles_y && !tree.bottomWall(tree.index(tx, ty))) {
+                int x = std::uniform_int_distribution<>(x0, x1 - 1)(gen);
+                grid.openBottom(grid.index(x, y1 - 1));
+            }
+        }
+    }
+
+    grid.openRight(grid.index(width - 1, height - 1)); // exit
+}
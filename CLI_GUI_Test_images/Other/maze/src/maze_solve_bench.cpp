@@ -0,0 +1,95 @@
+// FILE: maze_solve_bench.cpp
+// PURPOSE: Measures the breadth-first and A* maze solvers in cells per
+//          second, on mazes carved with the tiled generator, and checks
+//          that both find the same valid path. The last column turns the
+//          slower solver's speed into inches of paper per second for a
+//          50-column maze on the 1728-dot head at 203 dpi, to compare with
+//          the print speed of a long roll.
+//
+// AUTHOR: hamslices
+//
+// REQUIRES: maze_grid.h and maze_solver.h in the same directory;
+//           lark_parallel.h in ../../common.
+// USAGE: ./maze_solve_bench [<cols>x<rows> ...]   (default 50x70 1000x1000 4000x4000 10000x10000)
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <iomanip>
+#include <cstdio>
+#include <algorithm>
+
+#include "maze_grid.h"
+#include "maze_solver.h"
+
+double Seconds(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - since).count();
+}
+
+void Report(const std::string& name, double seconds, const MazeSolution& solution, size_t cells) {
+    std::cout << "  " << std::left << std::setw(6) << name << std::right << std::fixed
+        << std::setw(10) << std::setprecision(1) << seconds * 1000.0 << " ms"
+        << std::setw(10) << std::setprecision(1) << cells / seconds / 1e6 << " Mcells/s"
+        << std::setw(12) << solution.visited << " searched"
+        << std::setw(10) << solution.path.size() << " on path" << std::endl;
+}
+
+// The path must run from the entry to the exit through open walls only.
+bool IsValidPath(const MazeGrid& grid, const std::vector<uint32_t>& path) {
+    if (path.empty() || path.front() != 0 || path.back() != grid.cellCount() - 1) return false;
+    for (size_t i = 1; i < path.size(); ++i) {
+        uint32_t a = std::min(path[i - 1], path[i]), b = std::max(path[i - 1], path[i]);
+        bool open = (b == a + 1 && a % grid.width() != static_cast<uint32_t>(grid.width() - 1) && !grid.rightWall(a)) ||
+            (b == a + static_cast<uint32_t>(grid.width()) && !grid.bottomWall(a));
+        if (!open) return false;
+    }
+    return true;
+}
+
+// Returns false if either solver's path is wrong or they disagree.
+bool RunSize(int width, int height, uint32_t seed) {
+    size_t cells = static_cast<size_t>(width) * height;
+    std::cout << width << "x" << height << " (" << cells << " cells)" << std::endl;
+
+    MazeGrid grid(width, height);
+    GenerateTiled(grid, seed, 256, 256, DefaultThreadCount());
+    grid.releaseVisited();
+
+    auto t0 = std::chrono::steady_clock::now();
+    MazeSolution bfs = SolveBfs(grid);
+    double bfsTime = Seconds(t0);
+    Report("BFS", bfsTime, bfs, cells);
+
+    t0 = std::chrono::steady_clock::now();
+    MazeSolution astar = SolveAStar(grid);
+    double astarTime = Seconds(t0);
+    Report("A*", astarTime, astar, cells);
+
+    // Dots per cell row of a 50-column maze with square cells
+    const double columns = 50, cellDots = (1728 - 50) / 50, dpi = 203;
+    double inchesPerSecond = cells / std::max(bfsTime, astarTime) / columns * cellDots / dpi;
+    std::cout << "  keeps up with " << std::setprecision(0) << inchesPerSecond << " in/s of 50-column maze" << std::endl;
+
+    bool ok = IsValidPath(grid, bfs.path) && bfs.path == astar.path;
+    std::cout << "  path check: " << (ok ? "same valid path" : "FAILED") << std::endl;
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::pair<int, int>> sizes;
+    for (int i = 1; i < argc; ++i) {
+        int w, h;
+        if (std::sscanf(argv[i], "%dx%d", &w, &h) != 2 || w < 1 || h < 1 ||
+            static_cast<unsigned long long>(w) * h > 0xFFFFFFFFull) {
+            std::cerr << "Usage: " << argv[0] << " [<cols>x<rows> ...]" << std::endl;
+            return 1;
+        }
+        sizes.push_back({ w, h });
+    }
+    if (sizes.empty()) sizes = { { 50, 70 }, { 1000, 1000 }, { 4000, 4000 }, { 10000, 10000 } };
+
+    bool ok = true;
+    for (const auto& size : sizes) ok = RunSize(size.first, size.second, 12345) && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,193 @@
+// FILE: maze_solver.h
+// PURPOSE: Finds the path from the entry (left of the top-left cell) to the
+//          exit (right of the bottom-right cell) of a MazeGrid, for answer
+//          sheets.
+//
+//          Two engines share the same compact search state: a visited bit
+//          and the 2-bit side each cell was reached from, 3 bits per cell,
+//          so a 10000x10000 maze is solved in under 40 MB.
+//          - SolveBfs: breadth-first over a preallocated ring-buffer queue.
+//          - SolveAStar: A* ordered by path length plus the Manhattan
+//            distance to the exit, over a binary heap.
+//          In a perfect maze both return the same (only) path; A* usually
+//          takes fewer cells off its queue to find it.
+//
+// AUTHOR: hamslices
+//
+// REQUIRES: maze_grid.h in the same directory.
+// USAGE: MazeSolution solution = SolveBfs(grid);
+//        for (uint32_t cell : solution.path) { ... }   // entry to exit
+
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+#include "maze_grid.h"
+
+enum class SolverKind { Bfs, AStar };
+
+struct MazeSolution {
+    std::vector<uint32_t> path; // cell indices from the entry to the exit; empty if there is no way through
+    size_t visited = 0;         // cells taken off the queue
+};
+
+// Visited bits and, for every visited cell, the side that leads back
+// towards the entry.
+class SearchState {
+public:
+    explicit SearchState(size_t cells) : visited_((cells + 63) / 64, 0), from_((cells + 3) / 4, 0) {}
+
+    bool visited(size_t cell) const { return (visited_[cell >> 6] >> (cell & 63)) & 1; }
+    void visit(size_t cell, int back) {
+        visited_[cell >> 6] |= uint64_t(1) << (cell & 63);
+        from_[cell >> 2] |= static_cast<uint8_t>(back << ((cell & 3) * 2));
+    }
+    int from(size_t cell) const { return (from_[cell >> 2] >> ((cell & 3) * 2)) & 3; }
+
+private:
+    std::vector<uint64_t> visited_;
+    std::vector<uint8_t> from_;
+};
+
+// FIFO of cell indices in a power-of-two ring. It starts at the given size
+// and only grows (doubling) if the frontier ever outgrows it.
+class RingQueue {
+public:
+    explicit RingQueue(size_t capacity) {
+        size_t size = 16;
+        while (size < capacity) size *= 2;
+        items_.resize(size);
+        mask_ = size - 1;
+    }
+
+    bool empty() const { return head_ == tail_; }
+    void push(uint32_t cell) {
+        if (tail_ - head_ == items_.size()) grow();
+        items_[tail_++ & mask_] = cell;
+    }
+    uint32_t pop() { return items_[head_++ & mask_]; }
+
+private:
+    void grow() {
+        std::vector<uint32_t> larger(items_.size() * 2);
+        for (size_t i = head_; i != tail_; ++i) larger[i - head_] = items_[i & mask_];
+        tail_ -= head_;
+        head_ = 0;
+        items_.swap(larger);
+        mask_ = items_.size() - 1;
+    }
+
+    std::vector<uint32_t> items_;
+    size_t mask_ = 0;
+    size_t head_ = 0;
+    size_t tail_ = 0;
+};
+
+inline int OppositeSide(int side) { return side ^ 2; }
+
+// The cell across 'side' of 'cell'; the caller knows it is inside the grid.
+inline uint32_t CellAcross(const MazeGrid& grid, uint32_t cell, int side) {
+    switch (side) {
+    case WALL_TOP: return cell - grid.width();
+    case WALL_RIGHT: return cell + 1;
+    case WALL_BOTTOM: return cell + grid.width();
+    default: return cell - 1;
+    }
+}
+
+// Calls step(next, side) for every neighbour reachable from (x, y), where
+// 'side' is the side of 'next' that leads back to the cell.
+template <typename Step>
+void ForEachOpening(const MazeGrid& grid, uint32_t cell, int x, int y, Step step) {
+    const uint32_t width = grid.width();
+    if (y > 0 && !grid.bottomWall(cell - width)) step(cell - width, WALL_BOTTOM);
+    if (x + 1 < grid.width() && !grid.rightWall(cell)) step(cell + 1, WALL_LEFT);
+    if (y + 1 < grid.height() && !grid.bottomWall(cell)) step(cell + width, WALL_TOP);
+    if (x > 0 && !grid.rightWall(cell - 1)) step(cell - 1, WALL_RIGHT);
+}
+
+inline std::vector<uint32_t> TracePath(const MazeGrid& grid, const SearchState& state, uint32_t goal) {
+    std::vector<uint32_t> path;
+    for (uint32_t cell = goal;; cell = CellAcross(grid, cell, state.from(cell))) {
+        path.push_back(cell);
+        if (cell == 0) break;
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+inline MazeSolution SolveBfs(const MazeGrid& grid) {
+    MazeSolution solution;
+    const uint32_t width = grid.width();
+    const uint32_t goal = static_cast<uint32_t>(grid.cellCount() - 1);
+    SearchState state(grid.cellCount());
+    RingQueue queue(2 * (static_cast<size_t>(grid.width()) + grid.height()));
+
+    state.visit(0, WALL_LEFT);
+    queue.push(0);
+    while (!queue.empty()) {
+        uint32_t cell = queue.pop();
+        ++solution.visited;
+        if (cell == goal) {
+            solution.path = TracePath(grid, state, goal);
+            break;
+        }
+        ForEachOpening(grid, cell, cell % width, cell / width, [&](uint32_t next, int back) {
+            if (state.visited(next)) return;
+            state.visit(next, back);
+            queue.push(next);
+        });
+    }
+    return solution;
+}
+
+inline MazeSolution SolveAStar(const MazeGrid& grid) {
+    struct Entry {
+        uint32_t estimate; // steps so far plus the Manhattan distance left
+        uint32_t steps;
+        uint32_t cell;
+        int back;
+        // Lowest estimate first; among equals the one furthest along
+        bool operator<(const Entry& other) const {
+            return estimate != other.estimate ? estimate > other.estimate : steps < other.steps;
+        }
+    };
+    MazeSolution solution;
+    const uint32_t width = grid.width(), height = grid.height();
+    const uint32_t goal = static_cast<uint32_t>(grid.cellCount() - 1);
+    SearchState state(grid.cellCount());
+    std::vector<Entry> storage;
+    storage.reserve(2 * (static_cast<size_t>(width) + height));
+    std::priority_queue<Entry> open(std::less<Entry>(), std::move(storage));
+
+    // Cells are closed when they come off the heap, so the first time the
+    // exit comes off, its path is a shortest one
+    open.push({ width - 1 + height - 1, 0, 0, WALL_LEFT });
+    while (!open.empty()) {
+        Entry entry = open.top();
+        open.pop();
+        if (state.visited(entry.cell)) continue;
+        state.visit(entry.cell, entry.back);
+        ++solution.visited;
+        if (entry.cell == goal) {
+            solution.path = TracePath(grid, state, goal);
+            break;
+        }
+        uint32_t x = entry.cell % width, y = entry.cell / width;
+        ForEachOpening(grid, entry.cell, x, y, [&](uint32_t next, int back) {
+            if (state.visited(next)) return;
+            uint32_t nx = next % width, ny = next / width;
+            uint32_t steps = entry.steps + 1;
+            open.push({ steps + (width - 1 - nx) + (height - 1 - ny), steps, next, back });
+        });
+    }
+    return solution;
+}
+
+inline MazeSolution SolveMaze(const MazeGrid& grid, SolverKind kind) {
+    return kind == SolverKind::AStar ? SolveAStar(grid) : SolveBfs(grid);
+}
@@ -1,326 +1,977 @@
 // FILE: solar_flux_plot.cpp
 // PURPOSE: Plots solar flux data with all features: auto-scaling, clipping, labels, and hatched fill.
 //
+//          When "your_solar_data.csv.fluxcache" (csv_converter --cache) was
+//          made from the CSV as it is now, the columns are read from it and
+//          the CSV is not parsed at all. --from/--to plot only a date window;
+//          the CSV is then entered through a sparse index of Julian days
+//          (flux_index.h, built on first use as "your_solar_data.csv.fluxindex")
+//          so only the window's rows are parsed. The fixed-column
+//          fluxtable.txt can be given instead of the CSV, as downloaded.
+//
 // AUTHOR: hamslices
 // ASSISTANCE: Major portions of this code were developed in collaboration with Google's AI.
 //
-// REQUIRES: font8x8_basic.h in the same directory.
-// USAGE: ./solar_flux_plot "your_solar_data.csv"
+// REQUIRES: lark_bitmap.h, lark_text.h (with font8x8_basic.h), lark_raster.h,
+//           lark_image_writer.h, flux_csv_reader.h, flux_fixed_reader.h,
+//           flux_cache.h, flux_index.h, flux_datetime.h, lark_file_tail.h and
+//           lark_stats.h in ../../common. Define LARK_HAVE_ZLIB and link zlib
+//           for compressed PNG output.
+// USAGE: ./solar_flux_plot "your_solar_data.csv" [--band-height <rows>] [--format pgm|pbm|png]
+//            [--pixels-per-day <n>] [--clip-percent <p>] [--output <file>]
+//            [--series obs,adj,ursi] [--fill <a>[:<b>]|none ...] [--no-cache]
+//            [--from <YYYY-MM-DD|julian>] [--to <YYYY-MM-DD|julian>]
+//        (fluxtable.txt works wherever a .csv does)
+//        ./solar_flux_plot "your_solar_data.csv" --follow [--output <file>|-] [--idle-exit <s>] [--scale-window <rows>]
 
 #include <iostream>
 #include <vector>
 #include <string>
-#include <sstream>
 #include <algorithm>
 #include <fstream>
 #include <limits>
 #include <cmath>
-#include <iomanip> // Required for date formatting
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+
+#include "../../common/lark_bitmap.h"
+#include "../../common/lark_text.h"
+#include "../../common/lark_raster.h"
+#include "../../common/lark_image_writer.h"
+#include "../../common/flux_csv_reader.h"
+#include "../../common/flux_fixed_reader.h"
+#include "../../common/flux_cache.h"
+#include "../../common/flux_index.h"
+#include "../../common/flux_datetime.h"
+#include "../../common/lark_file_tail.h"
+#include "../../common/lark_stats.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+// --- PLOT LAYOUT ---
+
+// The flux columns of fluxtable.csv, in file order after the Carrington rotation
+enum FluxColumn { OBSERVED_FLUX, ADJUSTED_FLUX, URSI_FLUX, FLUX_COLUMNS };
+const char* const FLUX_COLUMN_NAMES[FLUX_COLUMNS] = { "obs", "adj", "ursi" }; // for --series and --fill
+const char* const FLUX_COLUMN_TITLES[FLUX_COLUMNS] = { "Observed", "Adjusted", "URSI" };
+
+// A hatched area on each row, between two series or from the left edge of
+// the plot (from < 0) to a series. Series are indices into PlotSeries::columns.
+struct AreaFill { int from; int to; };
 
-#include "font8x8_basic.h"
+// What to plot: the flux columns, in drawing order, and the hatched areas.
+// The default is the original plot, observed flux hatched from the left.
+struct PlotSeries {
+    std::vector<FluxColumn> columns = { OBSERVED_FLUX };
+    std::vector<AreaFill> fills = { { -1, 0 } };
 
-// --- DATE & TIME CONVERSION UTILITIES ---
+    int lastColumn() const { return *std::max_element(columns.begin(), columns.end()); }
+};
 
-// Extracts the date (YYYY-MM-DD) from a Julian Day number
-std::string julian_to_date(double julian_day) {
-    long long J = static_cast<long long>(julian_day + 0.5);
-    long long A;
-    if (J < 2299161) {
-        A = J;
+// One parsed CSV row.
+struct FluxRow { double julian; double carrington; double flux[FLUX_COLUMNS]; };
+
+// The parsed rows as columns (structure of arrays). Only the flux columns
+// being plotted are stored, and a pass over one series reads nothing else.
+struct FluxTable {
+    std::vector<double> julian;
+    std::vector<double> carrington;
+    std::vector<double> flux[FLUX_COLUMNS];
+
+    size_t size() const { return julian.size(); }
+
+    void append(const FluxRow& row, const PlotSeries& series) {
+        julian.push_back(row.julian);
+        carrington.push_back(row.carrington);
+        for (FluxColumn c : series.columns) flux[c].push_back(row.flux[c]);
     }
-    else {
-        long long alpha = static_cast<long long>((J - 1867216.25) / 36524.25);
-        A = J + 1 + alpha - static_cast<long long>(alpha / 4);
-    }
-    long long B = A + 1524;
-    long long C = static_cast<long long>((B - 122.1) / 365.25);
-    long long D = static_cast<long long>(365.25 * C);
-    long long E = static_cast<long long>((B - D) / 30.6001);
-    int day = static_cast<int>(B - D - static_cast<long long>(30.6001 * E));
-    int month = (E < 14) ? static_cast<int>(E - 1) : static_cast<int>(E - 13);
-    int year = (month > 2) ? static_cast<int>(C - 4716) : static_cast<int>(C - 4715);
-    std::stringstream ss;
-    ss << std::setfill('0') << std::setw(4) << year << "-"
-        << std::setw(2) << month << "-"
-        << std::setw(2) << day;
-    return ss.str();
-}
 
-// Converts the fractional part of a Carrington Rotation to time (HH:MM:SS)
-std::string carrington_to_time(double carrington_rotation) {
-    double fraction = carrington_rotation - static_cast<long long>(carrington_rotation);
-    double total_seconds = fraction * 24.0 * 3600.0;
-    int hours = static_cast<int>(total_seconds / 3600);
-    total_seconds -= hours * 3600;
-    int minutes = static_cast<int>(total_seconds / 60);
-    int seconds = static_cast<int>(total_seconds - minutes * 60);
-    std::stringstream ss;
-    ss << std::setfill('0') << std::setw(2) << hours << ":"
-        << std::setw(2) << minutes << ":"
-        << std::setw(2) << seconds;
-    return ss.str();
-}
+    // Forgets the first n rows.
+    void eraseFront(size_t n) {
+        auto drop = [n](std::vector<double>& v) { v.erase(v.begin(), v.begin() + std::min(n, v.size())); };
+        drop(julian);
+        drop(carrington);
+        for (auto& column : flux) drop(column);
+    }
+};
 
+const int PLOT_WIDTH = 1728; // dots across the print head
+const int PLOT_PADDING = 200;
+const double PIXELS_PER_DAY = 10.0; // default; --pixels-per-day
 
-// --- FONT & DRAWING UTILITIES ---
+// Maps data values onto the canvas. Fixed for the whole plot, so every band
+// agrees on where things land.
+struct PlotLayout {
+    int imgWidth;
+    int imgHeight;
+    int padding;
+    double visualMinFlux;
+    double visualMaxFlux;
+    double startJulian;
+    double timeRange;
+    double pixelsPerDay = 0.0; // > 0: open-ended strip (follow mode), Y grows with time
+    double clipPercent = 0.0;  // how the visual flux range was chosen, see FluxRangeEstimator
 
-void DrawBrush(std::vector<unsigned char>& buffer, int width, int height, int x, int y, int size, unsigned char color) {
-    int halfSize = size / 2;
-    for (int dy = -halfSize; dy <= halfSize; ++dy) {
-        for (int dx = -halfSize; dx <= halfSize; ++dx) {
-            int cX = x + dx, cY = y + dy;
-            if (cX >= 0 && cX < width && cY >= 0 && cY < height) {
-                buffer[cY * width + cX] = color;
-            }
+    int FluxToX(double flux) const {
+        double scaledFlux = (flux - visualMinFlux) / (visualMaxFlux - visualMinFlux);
+        int x = static_cast<int>(std::round(scaledFlux * (imgWidth - 2 * padding)) + padding);
+        return std::max(padding, std::min(imgWidth - padding, x));
+    }
+    int JulianToY(double julian) const {
+        if (pixelsPerDay > 0.0) {
+            return static_cast<int>(std::round((julian - startJulian) * pixelsPerDay)) + padding;
         }
+        return static_cast<int>(std::round(((julian - startJulian) / timeRange) * (imgHeight - 2 * padding)) + padding);
     }
+};
+
+// Parses one row (date, time, julian, carrington, observed, adjusted and
+// URSI flux), as far as the plotted columns need. Returns false for the
+// header and for short or malformed rows.
+bool ParseSolarRow(std::string_view line, const PlotSeries& series, const FluxRowFormat& format, FluxRow& row) {
+    std::string_view fields[5 + FLUX_COLUMNS];
+    size_t needed = 5 + series.lastColumn();
+    if (format.split(line, fields, needed) < needed) return false;
+    if (format.parse(fields[2], row.julian) != std::errc() || format.parse(fields[3], row.carrington) != std::errc()) return false;
+    for (FluxColumn c : series.columns) {
+        if (format.parse(fields[4 + c], row.flux[c]) != std::errc()) return false;
+    }
+    return true;
 }
 
-void DrawText(std::vector<unsigned char>& buffer, int width, int height, int x, int y, const std::string& text, int scale, unsigned char color) {
-    for (const char& c : text) {
-        if (c < 0 || c > 127) continue;
-        const unsigned char* glyph = font8x8_basic[static_cast<unsigned char>(c)];
-        for (int row = 0; row < 8; ++row) {
-            for (int col = 0; col < 8; ++col) {
-                if ((glyph[row] >> col) & 1) {
-                    for (int sy = 0; sy < scale; ++sy) {
-                        for (int sx = 0; sx < scale; ++sx) {
-                            int pX = x + (col * scale) + sx, pY = y + (row * scale) + sy;
-                            if (pX >= 0 && pX < width && pY >= 0 && pY < height) {
-                                buffer[pY * width + pX] = color;
-                            }
-                        }
-                    }
-                }
-            }
+// The rows to plot: Julian days from 'from' up to, not including, 'to'.
+struct JulianWindow {
+    double from = -std::numeric_limits<double>::infinity();
+    double to = std::numeric_limits<double>::infinity();
+
+    bool limited() const { return std::isfinite(from) || std::isfinite(to); }
+    bool contains(double julian) const { return julian >= from && julian < to; }
+};
+
+// Parses a --from/--to bound: a date, which covers that whole day, or a
+// Julian day. 'end' makes the bound inclusive (the window stops after it).
+bool ParseWindowBound(const std::string& text, bool end, double& julian) {
+    long long jdn;
+    if (parse_flux_date(text, jdn)) {
+        julian = static_cast<double>(jdn) + (end ? 0.5 : -0.5);
+        return true;
+    }
+    const char* last = text.data() + text.size();
+    auto result = std::from_chars(text.data(), last, julian);
+    if (result.ec != std::errc() || result.ptr != last || !std::isfinite(julian)) return false;
+    if (end) julian = std::nextafter(julian, std::numeric_limits<double>::infinity());
+    return true;
+}
+
+// Fills 'table' with the rows of a cache of the CSV that fall in 'window'.
+// Rows missing a plotted column are left out, as ParseSolarRow leaves them
+// out of the CSV; when there are none the columns are copied whole. A cache
+// in time order finds the window by binary search.
+void LoadFluxCache(const FluxCache& cache, const PlotSeries& series, const JulianWindow& window, FluxTable& table) {
+    const FluxCacheColumn CACHE_FLUX[FLUX_COLUMNS] = { CACHE_OBSERVED, CACHE_ADJUSTED, CACHE_URSI };
+    const double* julian = cache.column(CACHE_JULIAN);
+    const double* carrington = cache.column(CACHE_CARRINGTON);
+    size_t first = 0, last = cache.rows();
+    if (cache.sorted()) {
+        first = std::lower_bound(julian, julian + last, window.from) - julian;
+        last = std::lower_bound(julian + first, julian + last, window.to) - julian;
+    }
+    bool complete = cache.sorted();
+    for (FluxColumn c : series.columns) complete = complete && cache.missing(CACHE_FLUX[c]) == 0;
+    if (complete) {
+        table.julian.assign(julian + first, julian + last);
+        table.carrington.assign(carrington + first, carrington + last);
+        for (FluxColumn c : series.columns) table.flux[c].assign(cache.column(CACHE_FLUX[c]) + first, cache.column(CACHE_FLUX[c]) + last);
+        return;
+    }
+    for (size_t i = first; i < last; ++i) {
+        if (!window.contains(julian[i])) continue;
+        FluxRow row = { julian[i], carrington[i], {} };
+        bool usable = true;
+        for (FluxColumn c : series.columns) {
+            row.flux[c] = cache.column(CACHE_FLUX[c])[i];
+            usable = usable && !std::isnan(row.flux[c]);
         }
-        x += (8 * scale);
+        if (usable) table.append(row, series);
     }
 }
 
-void DrawDottedLine(int x1, int y1, int x2, int y2, std::vector<unsigned char>& buffer, int width, int height, int thickness, unsigned char color, int dash, int gap) {
-    int dx = std::abs(x2 - x1), sx = x1 < x2 ? 1 : -1, dy = -std::abs(y2 - y1), sy = y1 < y2 ? 1 : -1, err = dx + dy, e2, len = 0, total = dash + gap;
+// Parses --series: column names separated by commas, each at most once.
+bool ParseSeriesList(const std::string& list, std::vector<FluxColumn>& columns) {
+    columns.clear();
+    size_t start = 0;
     while (true) {
-        if (gap == 0 || (len % total) < dash) {
-            DrawBrush(buffer, width, height, x1, y1, thickness, color);
+        size_t comma = list.find(',', start);
+        std::string name = list.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        auto known = std::find_if(std::begin(FLUX_COLUMN_NAMES), std::end(FLUX_COLUMN_NAMES), [&](const char* n) { return name == n; });
+        if (known == std::end(FLUX_COLUMN_NAMES)) return false;
+        FluxColumn column = static_cast<FluxColumn>(known - std::begin(FLUX_COLUMN_NAMES));
+        if (std::find(columns.begin(), columns.end(), column) != columns.end()) return false;
+        columns.push_back(column);
+        if (comma == std::string::npos) return true;
+        start = comma + 1;
+    }
+}
+
+// Parses one --fill: "<a>" hatches from the left edge to series a, "<a>:<b>"
+// between series a and b. Both must be in the --series list.
+bool ParseFill(const std::string& spec, const std::vector<FluxColumn>& columns, AreaFill& fill) {
+    auto indexOf = [&](const std::string& name) {
+        for (size_t k = 0; k < columns.size(); ++k) {
+            if (name == FLUX_COLUMN_NAMES[columns[k]]) return static_cast<int>(k);
         }
-        if (x1 == x2 && y1 == y2) break;
-        e2 = 2 * err;
-        if (e2 >= dy) { err += dy; x1 += sx; }
-        if (e2 <= dx) { err += dx; y1 += sy; }
-        len++;
+        return -1;
+    };
+    size_t colon = spec.find(':');
+    if (colon == std::string::npos) {
+        fill = { -1, indexOf(spec) };
+        return fill.to >= 0;
     }
+    fill = { indexOf(spec.substr(0, colon)), indexOf(spec.substr(colon + 1)) };
+    return fill.from >= 0 && fill.to >= 0 && fill.from != fill.to;
 }
 
-void DrawLine(int x1, int y1, int x2, int y2, std::vector<unsigned char>& buffer, int width, int height, int thickness, unsigned char color) {
-    DrawDottedLine(x1, y1, x2, y2, buffer, width, height, thickness, color, 1, 0);
+// Chooses the visual flux range from flux values fed one at a time, so the
+// scale is known as soon as the rows are parsed.
+//   clipPercent 0: mean +/- 3 standard deviations, floored at zero.
+//   clipPercent p: the p and 100-p percentiles. Flare-heavy stretches inflate
+//                  the standard deviation; percentiles barely move.
+class FluxRangeEstimator {
+public:
+    explicit FluxRangeEstimator(double clipPercent = 0.0) : clipPercent_(clipPercent) {}
+
+    void add(double flux) {
+        stats_.add(flux);
+        if (clipPercent_ > 0.0) sketch_.add(flux);
+    }
+
+    size_t count() const { return stats_.count(); }
+
+    void apply(PlotLayout& layout) const {
+        const double STD_DEV_MULTIPLIER = 3.0;
+        layout.clipPercent = clipPercent_;
+        if (clipPercent_ > 0.0) {
+            layout.visualMinFlux = sketch_.quantile(clipPercent_ / 100.0);
+            layout.visualMaxFlux = sketch_.quantile(1.0 - clipPercent_ / 100.0);
+            if (layout.visualMaxFlux <= layout.visualMinFlux) layout.visualMaxFlux = layout.visualMinFlux + 1.0;
+            return;
+        }
+        layout.visualMinFlux = std::max(0.0, stats_.mean() - STD_DEV_MULTIPLIER * stats_.stdDev());
+        layout.visualMaxFlux = stats_.mean() + STD_DEV_MULTIPLIER * stats_.stdDev();
+    }
+
+private:
+    double clipPercent_;
+    RunningStats stats_;
+    QuantileSketch sketch_;
+};
+
+// Sets the visual flux range from every plotted series over all rows of
+// 'table'; the series share one flux axis.
+void ScaleToData(PlotLayout& layout, const FluxTable& table, const PlotSeries& series, double clipPercent) {
+    FluxRangeEstimator estimator(clipPercent);
+    for (FluxColumn c : series.columns) {
+        for (double flux : table.flux[c]) estimator.add(flux);
+    }
+    estimator.apply(layout);
 }
 
-void DrawTriangle(std::vector<unsigned char>& buffer, int width, int height, int x, int y, int size, bool pointsRight, unsigned char color) {
-    int dir = pointsRight ? 1 : -1;
-    DrawLine(x, y, x + (size * dir), y - (size / 2), buffer, width, height, 1, color);
-    DrawLine(x, y, x + (size * dir), y + (size / 2), buffer, width, height, 1, color);
-    DrawLine(x + (size * dir), y - (size / 2), x + (size * dir), y + (size / 2), buffer, width, height, 1, color);
+struct GridLine { int yPos; bool isYearStart; std::string label; };
+
+// *** MODIFIED: Logic for drawing Y-Axis labels every 3 months (quarterly) ***
+// Appends a gridline for every quarter in [firstJulian, lastJulian] that is
+// later than 'after' (follow mode adds them as the data advances).
+void AppendQuarterGridLines(std::vector<GridLine>& gridLines, const PlotLayout& layout, double firstJulian, double lastJulian,
+    double after = -std::numeric_limits<double>::infinity()) {
+    int startYear = static_cast<int>(std::round((firstJulian - 2440587.5) / 365.25));
+    int endYear = static_cast<int>(std::round((lastJulian - 2440587.5) / 365.25));
+    for (int year = startYear; year <= endYear; ++year) {
+        double yearAsJulian = (year * 365.25) + 2440587.5; // Approx Julian for Jan 1st of year
+        double quarterOffsets[] = { 0.0, 365.25 / 4.0, 365.25 / 2.0, 365.25 * 3.0 / 4.0 };
+
+        for (int q = 0; q < 4; ++q) {
+            double quarterJulian = yearAsJulian + quarterOffsets[q];
+            if (quarterJulian >= firstJulian && quarterJulian <= lastJulian && quarterJulian > after) {
+                gridLines.push_back({ layout.JulianToY(quarterJulian), q == 0, julian_to_date(quarterJulian) });
+            }
+        }
+    }
 }
 
-void DrawFilledRectangle(std::vector<unsigned char>& buffer, int width, int height, int x, int y, int w, int h, unsigned char color) {
-    for (int row = 0; row < h; ++row) {
-        for (int col = 0; col < w; ++col) {
-            int pX = x + col, pY = y + row;
-            if (pX >= 0 && pX < width && pY >= 0 && pY < height) {
-                buffer[pY * width + pX] = color;
+// The data polyline of one series in canvas coordinates. minYFrom[i] is the
+// smallest Y of any point at or after i, which lets a band skip straight to
+// the segments that can touch it even though the station data is not
+// strictly time-ordered. dotsBefore[i] counts the dots from the start of
+// the line to point i, so dashes run on across the joins.
+struct PlotTrace {
+    std::vector<int> xs;
+    std::vector<int> ys;
+    std::vector<int> minYFrom;
+    std::vector<long long> dotsBefore;
+    size_t cursor = 1;
+
+    // Calls fn(i) for every segment (i - 1, i) that may reach rows [yLo, yHi].
+    // Bands must be visited top to bottom.
+    template <typename Fn>
+    void ForEachSegment(int yLo, int yHi, Fn fn) {
+        while (cursor < ys.size() && std::max(ys[cursor - 1], ys[cursor]) < yLo) ++cursor;
+        for (size_t i = cursor; i < ys.size() && minYFrom[i - 1] <= yHi; ++i) {
+            if (std::max(ys[i - 1], ys[i]) >= yLo && std::min(ys[i - 1], ys[i]) <= yHi) fn(i);
+        }
+    }
+};
+
+// M4 reduction: in each run of consecutive points on the same canvas row,
+// only the first, leftmost, rightmost and last points matter. The line
+// covers every X between the leftmost and rightmost either way and the hatch
+// only reads the rightmost, so the points in between are dropped and the
+// printed output is unchanged. Dense data (many samples per row at the
+// chosen pixels per day) shrinks to at most four points per row.
+void DecimateTrace(PlotTrace& trace) {
+    std::vector<int>& xs = trace.xs;
+    std::vector<int>& ys = trace.ys;
+    size_t kept = 0;
+    auto keep = [&](size_t i) { xs[kept] = xs[i]; ys[kept] = ys[i]; ++kept; };
+    for (size_t start = 0; start < ys.size();) {
+        size_t end = start + 1;
+        while (end < ys.size() && ys[end] == ys[start]) ++end;
+        if (end - start <= 4) {
+            for (size_t i = start; i < end; ++i) keep(i);
+        }
+        else {
+            size_t left = start, right = start;
+            for (size_t i = start + 1; i < end; ++i) {
+                if (xs[i] < xs[left]) left = i;
+                if (xs[i] > xs[right]) right = i;
+            }
+            size_t picks[4] = { start, std::min(left, right), std::max(left, right), end - 1 };
+            for (int k = 0; k < 4; ++k) {
+                if (k == 0 || picks[k] != picks[k - 1]) keep(picks[k]);
             }
         }
+        start = end;
     }
+    xs.resize(kept);
+    ys.resize(kept);
 }
 
-// --- MAIN APPLICATION ---
+// Projects every series onto the canvas, one trace each, and decimates
+// them. The rows are computed once for all series. Also lists the rows
+// whose first series falls outside the visual flux range, which get
+// clipped labels.
+void BuildTraces(const PlotLayout& layout, const FluxTable& table, const PlotSeries& series, std::vector<PlotTrace>& traces,
+    std::vector<size_t>& outliers) {
+    std::vector<int> rows(table.size());
+    for (size_t i = 0; i < table.size(); ++i) rows[i] = layout.JulianToY(table.julian[i]);
 
-struct SolarDataPoint { double julianDate; double carringtonRotation; double observedFlux; };
+    traces.assign(series.columns.size(), PlotTrace());
+    outliers.clear();
+    for (size_t k = 0; k < series.columns.size(); ++k) {
+        const std::vector<double>& flux = table.flux[series.columns[k]];
+        PlotTrace& trace = traces[k];
+        trace.xs.resize(flux.size());
+        for (size_t i = 0; i < flux.size(); ++i) trace.xs[i] = layout.FluxToX(flux[i]);
+        trace.ys = rows;
+        if (k == 0) {
+            for (size_t i = 0; i < flux.size(); ++i) {
+                if (flux[i] > layout.visualMaxFlux || flux[i] < layout.visualMinFlux) outliers.push_back(i);
+            }
+        }
+        DecimateTrace(trace);
 
-int main(int argc, char* argv[]) {
-    // 1. --- FILE HANDLING, PARSING, STATS, and CANVAS SETUP ---
-    if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <solar_flux_data.csv>" << std::endl;
-        return 1;
+        size_t n = trace.ys.size();
+        trace.minYFrom.resize(n);
+        int runningMin = std::numeric_limits<int>::max();
+        for (size_t i = n; i-- > 0;) {
+            runningMin = std::min(runningMin, trace.ys[i]);
+            trace.minYFrom[i] = runningMin;
+        }
+        trace.dotsBefore.resize(n);
+        long long dots = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (i > 0) dots += std::max(std::abs(trace.xs[i] - trace.xs[i - 1]), std::abs(trace.ys[i] - trace.ys[i - 1]));
+            trace.dotsBefore[i] = dots;
+        }
     }
-    std::string filename = argv[1];
-    std::ifstream dataFile(filename);
-    if (!dataFile.is_open()) {
-        std::cerr << "Error: Could not open file '" << filename << "'" << std::endl;
-        return 1;
+}
+
+const int TEXT_SCALE = 2;
+const int PLOT_THICKNESS = 3; // the thickest series line
+
+// How each series is drawn, by its place in the --series list; the first
+// keeps the original solid line.
+struct SeriesStyle { int thickness; int dash; int gap; };
+const SeriesStyle SERIES_STYLES[FLUX_COLUMNS] = { { PLOT_THICKNESS, 1, 0 }, { PLOT_THICKNESS, 9, 6 }, { 1, 1, 0 } };
+
+// The rightmost X of the trace on each row of the band, 0 where it has none.
+// A fill reads its edges from these.
+template <typename Bitmap>
+void FindRightEdges(const Bitmap& band, PlotTrace& trace, std::vector<int>& right) {
+    const int bandBottom = band.top + band.height - 1;
+    int halfThickness = PLOT_THICKNESS / 2;
+    right.assign(band.height, 0);
+    trace.ForEachSegment(band.top - halfThickness, bandBottom + halfThickness, [&](size_t i) {
+        LineWalker walker(trace.xs[i - 1], trace.ys[i - 1], trace.xs[i], trace.ys[i]);
+        for (int n = walker.steps(); n > 0; --n, walker.step()) {
+            if (walker.y >= band.top && walker.y <= bandBottom) {
+                int& boundary = right[walker.y - band.top];
+                boundary = std::max(boundary, walker.x);
+            }
+        }
+    });
+}
+
+// A line sample and the name of each series, centered on row y, when more
+// than one series is plotted.
+template <typename Bitmap>
+void DrawLegend(Bitmap& band, const PlotLayout& layout, const PlotSeries& series, int y) {
+    const int SAMPLE = 60, SPACE = 12, GAP = 48;
+    if (series.columns.size() < 2 || !band.IntersectsRows(y, y + 8 * TEXT_SCALE)) return;
+    int width = -GAP;
+    for (FluxColumn c : series.columns) width += SAMPLE + SPACE + static_cast<int>(std::strlen(FLUX_COLUMN_TITLES[c])) * 8 * TEXT_SCALE + GAP;
+    int x = (layout.imgWidth - width) / 2, middle = y + 8 * TEXT_SCALE / 2;
+    for (size_t k = 0; k < series.columns.size(); ++k) {
+        const SeriesStyle& style = SERIES_STYLES[k];
+        DrawDashedLine(band, x, middle, x + SAMPLE, middle, style.thickness, 0, style.dash, style.gap);
+        x += SAMPLE + SPACE;
+        std::string title = FLUX_COLUMN_TITLES[series.columns[k]];
+        DrawText(band, x, y, title, TEXT_SCALE, 0);
+        x += static_cast<int>(title.length()) * 8 * TEXT_SCALE + GAP;
     }
-    std::vector<SolarDataPoint> points;
-    std::string line;
-    std::getline(dataFile, line);
-    while (std::getline(dataFile, line)) {
-        std::replace(line.begin(), line.end(), ',', ' ');
-        std::stringstream ss(line);
-        std::string dummy;
-        double julian, carrington, flux;
-        ss >> dummy >> dummy >> julian >> carrington >> flux;
-        if (!ss.fail()) {
-            points.push_back({ julian, carrington, flux });
-        }
-    }
-    dataFile.close();
-    if (points.empty()) {
-        std::cerr << "Error: No valid data points were read." << std::endl;
-        return 1;
+}
+
+// Flux value labels for the ten vertical gridlines, with their tops at row y.
+template <typename Bitmap>
+void DrawFluxTickLabels(Bitmap& band, const PlotLayout& layout, int y) {
+    int numFluxTicks = 10;
+    double visualFluxRange = layout.visualMaxFlux - layout.visualMinFlux;
+    for (int i = 0; i <= numFluxTicks; ++i) {
+        double fluxValue = layout.visualMinFlux + i * (visualFluxRange / numFluxTicks);
+        int xPos = static_cast<int>(std::round((double)i / numFluxTicks * (layout.imgWidth - 2 * layout.padding)) + layout.padding);
+        std::string label = std::to_string(static_cast<int>(fluxValue));
+        DrawText(band, xPos - (label.length() * 8 * TEXT_SCALE / 2), y, label, TEXT_SCALE, 0);
     }
-    std::cout << "Successfully read " << points.size() << " data points." << std::endl;
-    double sum = 0.0;
-    for (const auto& p : points) { sum += p.observedFlux; }
-    double mean = sum / points.size();
-    double sum_sq_diff = 0.0;
-    for (const auto& p : points) { sum_sq_diff += (p.observedFlux - mean) * (p.observedFlux - mean); }
-    double std_dev = std::sqrt(sum_sq_diff / points.size());
-    const double STD_DEV_MULTIPLIER = 3.0;
-    double visualMinFlux = std::max(0.0, mean - STD_DEV_MULTIPLIER * std_dev);
-    double visualMaxFlux = mean + STD_DEV_MULTIPLIER * std_dev;
-    std::cout << "Visual flux range set to: " << visualMinFlux << " -> " << visualMaxFlux << std::endl;
-    const int imgWidth = 1728;
-    const int padding = 200;
-    const double PIXELS_PER_DAY = 10.0;
-    double timeRange = points.back().julianDate - points.front().julianDate;
-    double visualFluxRange = visualMaxFlux - visualMinFlux;
-    int imgHeight = static_cast<int>(std::round(timeRange * PIXELS_PER_DAY)) + (2 * padding);
-    std::vector<unsigned char> imageBuffer(imgWidth * imgHeight, 255);
-
-    // 2. --- RENDER BACKGROUND (LABELS & GRIDLINES) ---
-    std::cout << "Rendering labels and gridlines..." << std::endl;
-    const int TEXT_SCALE = 2;
+}
+
+// The subtitle's account of the flux scale, e.g. "Clipped to Percentiles 1-99"
+std::string ScaleDescription(double clipPercent) {
+    if (clipPercent <= 0.0) return "Scaled to 3 Sigma";
+    char text[64];
+    std::snprintf(text, sizeof(text), "Clipped to Percentiles %g-%g", clipPercent, 100.0 - clipPercent);
+    return text;
+}
+
+// Renders every plot layer that touches the band, in the same order the
+// layers would be painted onto a full canvas.
+template <typename Bitmap>
+void RenderBand(Bitmap& band, const PlotLayout& layout, const FluxTable& table, const PlotSeries& series, std::vector<PlotTrace>& traces,
+    const std::vector<GridLine>& gridLines, const std::vector<size_t>& outliers) {
+    band.Clear(255);
+    const int imgWidth = layout.imgWidth, imgHeight = layout.imgHeight, padding = layout.padding;
+    const int bandBottom = band.top + band.height - 1;
+
+    // Labels and gridlines
     unsigned char gridColor = 0;
     int gridThickness = 1;
     std::string title = "Penticton 10.7cm Solar Flux";
-    std::string subtitle = "Observed Flux (sfu) - Scaled to 3 Sigma";
-    DrawText(imageBuffer, imgWidth, imgHeight, (imgWidth / 2) - (title.length() * 8 * TEXT_SCALE / 2), 30, title, TEXT_SCALE, 0);
-    DrawText(imageBuffer, imgWidth, imgHeight, (imgWidth / 2) - (subtitle.length() * 8 * TEXT_SCALE / 2), 65, subtitle, TEXT_SCALE, 0);
+    std::string subtitle;
+    for (FluxColumn c : series.columns) subtitle += std::string(subtitle.empty() ? "" : " / ") + FLUX_COLUMN_TITLES[c];
+    subtitle += " Flux (sfu) - " + ScaleDescription(layout.clipPercent);
+    DrawText(band, (imgWidth / 2) - (title.length() * 8 * TEXT_SCALE / 2), 30, title, TEXT_SCALE, 0);
+    DrawText(band, (imgWidth / 2) - (subtitle.length() * 8 * TEXT_SCALE / 2), 65, subtitle, TEXT_SCALE, 0);
+    DrawLegend(band, layout, series, 105);
     int numFluxTicks = 10;
     for (int i = 0; i <= numFluxTicks; ++i) {
-        double fluxValue = visualMinFlux + i * (visualFluxRange / numFluxTicks);
         int xPos = static_cast<int>(std::round((double)i / numFluxTicks * (imgWidth - 2 * padding)) + padding);
-        DrawDottedLine(xPos, padding, xPos, imgHeight - padding, imageBuffer, imgWidth, imgHeight, gridThickness, gridColor, 5, 5);
-        std::string label = std::to_string(static_cast<int>(fluxValue));
-        DrawText(imageBuffer, imgWidth, imgHeight, xPos - (label.length() * 8 * TEXT_SCALE / 2), padding - 40, label, TEXT_SCALE, 0);
+        DrawDashedLine(band, xPos, padding, xPos, imgHeight - padding, gridThickness, gridColor, 5, 5);
+    }
+    DrawFluxTickLabels(band, layout, padding - 40);
+    for (const auto& g : gridLines) {
+        // Use a solid line for the start of the year, dotted for other quarters
+        DrawDashedLine(band, padding, g.yPos, imgWidth - padding, g.yPos, gridThickness, gridColor, g.isYearStart ? 1 : 5, g.isYearStart ? 0 : 5);
+        DrawText(band, padding - (g.label.length() * 8 * TEXT_SCALE) - 15, g.yPos - (8 * TEXT_SCALE / 2), g.label, TEXT_SCALE, 0);
     }
 
-    // *** MODIFIED: Logic for drawing Y-Axis labels every 3 months (quarterly) ***
-    int startYear = static_cast<int>(std::round((points.front().julianDate - 2440587.5) / 365.25));
-    int endYear = static_cast<int>(std::round((points.back().julianDate - 2440587.5) / 365.25));
-    for (int year = startYear; year <= endYear; ++year) {
-        double yearAsJulian = (year * 365.25) + 2440587.5; // Approx Julian for Jan 1st of year
-        double quarterOffsets[] = { 0.0, 365.25 / 4.0, 365.25 / 2.0, 365.25 * 3.0 / 4.0 };
-
-        for (int q = 0; q < 4; ++q) {
-            double quarterJulian = yearAsJulian + quarterOffsets[q];
-            if (quarterJulian >= points.front().julianDate && quarterJulian <= points.back().julianDate) {
-                int yPos = static_cast<int>(std::round(((quarterJulian - points.front().julianDate) / timeRange) * (imgHeight - 2 * padding)) + padding);
-
-                // Use a solid line for the start of the year, dotted for other quarters
-                bool isYearStart = (q == 0);
-                DrawDottedLine(padding, yPos, imgWidth - padding, yPos, imageBuffer, imgWidth, imgHeight, gridThickness, gridColor, isYearStart ? 1 : 5, isYearStart ? 0 : 5);
-
-                std::string label = julian_to_date(quarterJulian);
-                DrawText(imageBuffer, imgWidth, imgHeight, padding - (label.length() * 8 * TEXT_SCALE) - 15, yPos - (8 * TEXT_SCALE / 2), label, TEXT_SCALE, 0);
+    // Hatched areas, between the rightmost X of two series on each row of
+    // this band or from the left edge to one; each area has its own hatch
+    unsigned char hatchColor = 0;
+    const FillPattern hatches[] = { FillPattern::Hatch(8), FillPattern::BackHatch(8), FillPattern::Hatch(4) };
+    std::vector<std::vector<int>> rightEdges(traces.size());
+    for (size_t f = 0; f < series.fills.size(); ++f) {
+        const AreaFill& fill = series.fills[f];
+        for (int k : { fill.from, fill.to }) {
+            if (k >= 0 && rightEdges[k].empty()) FindRightEdges(band, traces[k], rightEdges[k]);
+        }
+        const FillPattern& hatch = hatches[f % 3];
+        for (int y = std::max(padding, band.top); y < std::min(imgHeight - padding, bandBottom + 1); ++y) {
+            int to = rightEdges[fill.to][y - band.top];
+            int from = fill.from < 0 ? padding : rightEdges[fill.from][y - band.top];
+            if (to > 0 && from > 0) {
+                FillPatternSpan(band, std::min(from, to), std::max(from, to), y, hatch, hatchColor);
             }
         }
     }
 
-    // 3. --- RENDER HATCHED AREA ---
-    std::cout << "Rendering hatched area..." << std::endl;
-    unsigned char hatchColor = 0;
-    int hatchSpacing = 8;
-    std::vector<int> scanline_boundary(imgHeight, 0);
-    int lastX_hatch = -1, lastY_hatch = -1;
-    for (const auto& p : points) {
-        double scaledFlux = (p.observedFlux - visualMinFlux) / visualFluxRange;
-        int currentX = static_cast<int>(std::round(scaledFlux * (imgWidth - 2 * padding)) + padding);
-        currentX = std::max(padding, std::min(imgWidth - padding, currentX));
-        int currentY = static_cast<int>(std::round(((p.julianDate - points.front().julianDate) / timeRange) * (imgHeight - 2 * padding)) + padding);
-        if (lastX_hatch != -1) {
-            int dx = std::abs(currentX - lastX_hatch), sx = lastX_hatch < currentX ? 1 : -1, dy = -std::abs(currentY - lastY_hatch), sy = lastY_hatch < currentY ? 1 : -1, err = dx + dy, e2;
-            int x = lastX_hatch, y = lastY_hatch;
-            while (true) {
-                if (y >= 0 && y < imgHeight) {
-                    if (scanline_boundary[y] == 0 || x > scanline_boundary[y]) {
-                        scanline_boundary[y] = x;
-                    }
-                }
-                if (x == currentX && y == currentY) break;
-                e2 = 2 * err;
-                if (e2 >= dy) { err += dy; x += sx; }
-                if (e2 <= dx) { err += dx; y += sy; }
+    // Plot data lines
+    int halfThickness = PLOT_THICKNESS / 2;
+    for (size_t k = 0; k < traces.size(); ++k) {
+        const SeriesStyle& style = SERIES_STYLES[k];
+        PlotTrace& trace = traces[k];
+        trace.ForEachSegment(band.top - halfThickness, bandBottom + halfThickness, [&](size_t i) {
+            if (style.gap == 0) {
+                DrawLine(band, trace.xs[i - 1], trace.ys[i - 1], trace.xs[i], trace.ys[i], style.thickness, 0);
+            }
+            else {
+                DrawDashedLine(band, trace.xs[i - 1], trace.ys[i - 1], trace.xs[i], trace.ys[i], style.thickness, 0,
+                    style.dash, style.gap, trace.dotsBefore[i - 1]);
             }
+        });
+    }
+
+    // Clipped outlier labels
+    int textHeight = 8 * TEXT_SCALE;
+    const std::vector<double>& labelFlux = table.flux[series.columns.front()];
+    for (size_t index : outliers) {
+        double flux = labelFlux[index];
+        int currentY = layout.JulianToY(table.julian[index]);
+        if (!band.IntersectsRows(currentY - textHeight - 2, currentY + 5)) continue;
+        char datetime[FLUX_DATETIME_CHARS];
+        format_flux_datetime(table.julian[index], table.carrington[index], datetime);
+        std::string flux_part = std::to_string(static_cast<int>(flux));
+        std::string label = std::string(datetime, FLUX_DATETIME_CHARS) + " | " + flux_part + " sfu";
+        int textWidth = label.length() * 8 * TEXT_SCALE;
+        if (flux > layout.visualMaxFlux) {
+            int xPos = imgWidth - padding;
+            int textX = xPos - textWidth - 15, textY = currentY - textHeight;
+            FillRect(band, textX - 2, textY - 2, textWidth + 4, textHeight + 4, 255);
+            DrawText(band, textX, textY, label, TEXT_SCALE, 0);
+            DrawTriangle(band, xPos - 5, currentY, 10, false, 0);
         }
-        lastX_hatch = currentX; lastY_hatch = currentY;
+        else {
+            int xPos = padding;
+            int textX = xPos + 15, textY = currentY - textHeight;
+            FillRect(band, textX - 2, textY - 2, textWidth + 4, textHeight + 4, 255);
+            DrawText(band, textX, textY, label, TEXT_SCALE, 0);
+            DrawTriangle(band, xPos + 5, currentY, 10, true, 0);
+        }
+    }
+}
+
+// Renders the canvas top to bottom one band at a time, handing each finished
+// band to emit(). The last band may be shorter than bandHeight.
+template <typename Bitmap, typename EmitBand>
+void RenderBands(int bandHeight, const PlotLayout& layout, const FluxTable& table, const PlotSeries& series, std::vector<PlotTrace>& traces,
+    const std::vector<GridLine>& gridLines, const std::vector<size_t>& outliers, EmitBand emit) {
+    Bitmap band(layout.imgWidth, bandHeight);
+    for (int top = 0; top < layout.imgHeight; top += bandHeight) {
+        int rows = std::min(bandHeight, layout.imgHeight - top);
+        if (rows != band.height) band = Bitmap(layout.imgWidth, rows);
+        band.top = top;
+        RenderBand(band, layout, table, series, traces, gridLines, outliers);
+        emit(band);
+    }
+}
+
+// --- FOLLOW MODE ---
+
+struct FollowOptions {
+    std::string outputFilename; // "-" writes to stdout
+    int bandHeight = 256;
+    int pollMs = 1000;
+    double idleExitSeconds = 0.0; // 0: follow forever
+    size_t scaleWindow = 0;       // 0: keep the scale from the rows present at start
+    double clipPercent = 0.0;     // see FluxRangeEstimator
+    double pixelsPerDay = PIXELS_PER_DAY;
+    PlotSeries series;
+};
+
+// Treats the CSV as a live feed: renders what is there, then keeps watching
+// the file and emits each band of plot rows as soon as no later row can touch
+// it. Rows go out as headerless 1-bit scanlines (216 bytes per 1728-dot row),
+// the print-head format, so the output can be piped straight to the printer.
+int RunFollow(const std::string& filename, const FollowOptions& options) {
+    FileTail tail;
+    if (!tail.open(filename)) {
+        std::cerr << "Error: Could not open file '" << filename << "'" << std::endl;
+        return 1;
+    }
+    std::ofstream outputFile;
+    std::ostream* out = &std::cout;
+    if (options.outputFilename != "-") {
+        outputFile.open(options.outputFilename, std::ios::out | std::ios::binary);
+        if (!outputFile) {
+            std::cerr << "Error: Could not create output file '" << options.outputFilename << "'" << std::endl;
+            return 1;
+        }
+        out = &outputFile;
+    }
+#ifdef _WIN32
+    else {
+        _setmode(_fileno(stdout), _O_BINARY);
     }
-    for (int y = padding; y < imgHeight - padding; ++y) {
-        int x_boundary = scanline_boundary[y];
-        if (x_boundary > 0) {
-            for (int x = padding; x < x_boundary; ++x) {
-                if ((x + y) % hatchSpacing == 0) {
-                    imageBuffer[y * imgWidth + x] = hatchColor;
+#endif
+
+    PlotLayout layout;
+    layout.imgWidth = PLOT_WIDTH;
+    layout.padding = PLOT_PADDING;
+    layout.pixelsPerDay = options.pixelsPerDay;
+    layout.imgHeight = std::numeric_limits<int>::max() / 2; // unknown until the feed stops
+    layout.timeRange = 0.0;
+
+    const PlotSeries& series = options.series;
+    FluxTable pending;                        // rows that can still touch unwritten rows
+    FluxTable recent;                         // last scaleWindow rows, for the scale estimate
+    std::vector<GridLine> gridLines;
+    FluxRangeEstimator startScale(options.clipPercent);
+    double lastJulian = 0.0, gridThrough = -std::numeric_limits<double>::infinity();
+    bool started = false, headerSkipped = false, formatKnown = false;
+    FluxRowFormat rowFormat;
+    int nextRow = 0;                          // first canvas row not yet written
+    long long rowsWritten = 0;
+    MonoBitmap band(layout.imgWidth, options.bandHeight);
+    std::vector<PlotTrace> traces;
+    std::vector<size_t> outliers;
+
+    // Renders and writes bands until 'limit' rows are out. Partial bands are
+    // only written when finishing.
+    auto emitThrough = [&](int limit, bool finishing) {
+        while (nextRow < limit && (finishing || nextRow + options.bandHeight <= limit)) {
+            bool rescaled = false;
+            if (options.scaleWindow > 0 && recent.size() >= 2) {
+                // Rescale only on a real change so the strip doesn't jitter
+                PlotLayout proposed = layout;
+                ScaleToData(proposed, recent, series, options.clipPercent);
+                double range = layout.visualMaxFlux - layout.visualMinFlux;
+                if (std::abs(proposed.visualMinFlux - layout.visualMinFlux) > 0.05 * range ||
+                    std::abs(proposed.visualMaxFlux - layout.visualMaxFlux) > 0.05 * range) {
+                    layout.visualMinFlux = proposed.visualMinFlux;
+                    layout.visualMaxFlux = proposed.visualMaxFlux;
+                    rescaled = nextRow > 0;
+                    std::cerr << "Visual flux range now: " << layout.visualMinFlux << " -> " << layout.visualMaxFlux << std::endl;
                 }
             }
+            int rows = std::min(options.bandHeight, limit - nextRow);
+            if (rows != band.height) band = MonoBitmap(layout.imgWidth, rows);
+            band.top = nextRow;
+            BuildTraces(layout, pending, series, traces, outliers);
+            RenderBand(band, layout, pending, series, traces, gridLines, outliers);
+            if (rescaled) {
+                // Mark the new scale where it takes effect
+                FillRect(band, layout.padding, band.top, layout.imgWidth - 2 * layout.padding, 8 * TEXT_SCALE + 6, 255);
+                DrawFluxTickLabels(band, layout, band.top + 3);
+            }
+            out->write(reinterpret_cast<const char*>(band.bits.data()), band.bits.size());
+            out->flush();
+            nextRow += rows;
+            rowsWritten += rows;
+
+            // Forget what lies wholly above the rows already written
+            size_t drop = 0;
+            while (drop + 1 < pending.size() &&
+                std::max(layout.JulianToY(pending.julian[drop]), layout.JulianToY(pending.julian[drop + 1])) + 5 < nextRow) {
+                ++drop;
+            }
+            pending.eraseFront(drop);
+            gridLines.erase(std::remove_if(gridLines.begin(), gridLines.end(),
+                [&](const GridLine& g) { return g.yPos + 8 * TEXT_SCALE < nextRow; }), gridLines.end());
+        }
+    };
+
+    std::cerr << "Following '" << filename << "' (Ctrl+C to stop)..." << std::endl;
+    auto lastData = std::chrono::steady_clock::now();
+    while (true) {
+        std::string text;
+        bool restarted = false;
+        if (!tail.read(text, restarted)) {
+            std::cerr << "Error: Lost access to '" << filename << "'" << std::endl;
+            break;
+        }
+        if (restarted) {
+            std::cerr << "Warning: '" << filename << "' shrank; following it again from the top." << std::endl;
+            headerSkipped = false;
+            formatKnown = false;
         }
-    }
 
-    // 4. --- RENDER THE PLOT DATA LINE ---
-    std::cout << "Rendering plot data line..." << std::endl;
-    const int PLOT_THICKNESS = 3;
-    int lastX = -1, lastY = -1;
-    for (const auto& p : points) {
-        double scaledFlux = (p.observedFlux - visualMinFlux) / visualFluxRange;
-        int currentX = static_cast<int>(std::round(scaledFlux * (imgWidth - 2 * padding)) + padding);
-        currentX = std::max(padding, std::min(imgWidth - padding, currentX));
-        int currentY = static_cast<int>(std::round(((p.julianDate - points.front().julianDate) / timeRange) * (imgHeight - 2 * padding)) + padding);
-        if (lastX != -1) {
-            DrawLine(lastX, lastY, currentX, currentY, imageBuffer, imgWidth, imgHeight, PLOT_THICKNESS, 0);
-        }
-        lastX = currentX; lastY = currentY;
-    }
-
-    // 5. --- RENDER CLIPPED LABELS ---
-    std::cout << "Rendering clipped outlier labels..." << std::endl;
-    for (const auto& p : points) {
-        if (p.observedFlux > visualMaxFlux || p.observedFlux < visualMinFlux) {
-            int currentY = static_cast<int>(std::round(((p.julianDate - points.front().julianDate) / timeRange) * (imgHeight - 2 * padding)) + padding);
-            std::string date_part = julian_to_date(p.julianDate);
-            std::string time_part = carrington_to_time(p.carringtonRotation);
-            std::string flux_part = std::to_string(static_cast<int>(p.observedFlux));
-            std::string label = date_part + " " + time_part + " | " + flux_part + " sfu";
-            int textWidth = label.length() * 8 * TEXT_SCALE;
-            int textHeight = 8 * TEXT_SCALE;
-            if (p.observedFlux > visualMaxFlux) {
-                int xPos = imgWidth - padding;
-                int textX = xPos - textWidth - 15, textY = currentY - textHeight;
-                DrawFilledRectangle(imageBuffer, imgWidth, imgHeight, textX - 2, textY - 2, textWidth + 4, textHeight + 4, 255);
-                DrawText(imageBuffer, imgWidth, imgHeight, textX, textY, label, TEXT_SCALE, 0);
-                DrawTriangle(imageBuffer, imgWidth, imgHeight, xPos - 5, currentY, 10, false, 0);
+        CsvLineReader reader(text.data(), text.data() + text.size());
+        std::string_view line;
+        size_t added = 0;
+        while (reader.nextLine(line)) {
+            if (!headerSkipped) { headerSkipped = true; continue; }
+            if (!formatKnown) {
+                // fluxtable.txt has a line of dashes under the header
+                formatKnown = true;
+                if (ReadFixedColumns(line, rowFormat.columns)) continue;
             }
-            else {
-                int xPos = padding;
-                int textX = xPos + 15, textY = currentY - textHeight;
-                DrawFilledRectangle(imageBuffer, imgWidth, imgHeight, textX - 2, textY - 2, textWidth + 4, textHeight + 4, 255);
-                DrawText(imageBuffer, imgWidth, imgHeight, textX, textY, label, TEXT_SCALE, 0);
-                DrawTriangle(imageBuffer, imgWidth, imgHeight, xPos + 5, currentY, 10, true, 0);
+            FluxRow row;
+            if (!ParseSolarRow(line, series, rowFormat, row)) continue;
+            pending.append(row, series);
+            if (!started) {
+                for (FluxColumn c : series.columns) startScale.add(row.flux[c]);
             }
+            if (options.scaleWindow > 0) recent.append(row, series);
+            lastJulian = std::max(lastJulian, row.julian);
+            ++added;
+        }
+        if (recent.size() > options.scaleWindow) recent.eraseFront(recent.size() - options.scaleWindow);
+
+        if (!started && pending.size() >= 2) {
+            // The rows present at start set the scale, as in a normal plot
+            layout.startJulian = pending.julian.front();
+            startScale.apply(layout);
+            started = true;
+            std::cerr << "Visual flux range set to: " << layout.visualMinFlux << " -> " << layout.visualMaxFlux << std::endl;
+        }
+        if (started && added > 0) {
+            AppendQuarterGridLines(gridLines, layout, layout.startJulian, lastJulian, gridThrough);
+            gridThrough = lastJulian;
+            // A later row can still draw its segment and outlier label up to
+            // a label's height above the newest point; everything above is final.
+            emitThrough(layout.JulianToY(lastJulian) - (8 * TEXT_SCALE + 2) - 1, false);
+        }
+
+        if (added > 0) {
+            lastData = std::chrono::steady_clock::now();
+            continue;
         }
+        double idle = std::chrono::duration<double>(std::chrono::steady_clock::now() - lastData).count();
+        if (options.idleExitSeconds > 0.0 && idle >= options.idleExitSeconds) {
+            // The writer has stopped, so a row without its newline is final
+            std::string rest;
+            tail.takePartial(rest);
+            FluxRow row;
+            if (started && ParseSolarRow(rest, series, rowFormat, row)) {
+                pending.append(row, series);
+                lastJulian = std::max(lastJulian, row.julian);
+                AppendQuarterGridLines(gridLines, layout, layout.startJulian, lastJulian, gridThrough);
+            }
+            break;
+        }
+        tail.wait(options.pollMs);
     }
 
-    // 6. --- SAVE TO PGM FILE ---
-    std::string outputFilename = "solar_flux_plot.pgm";
-    std::ofstream ofs(outputFilename);
-    ofs << "P2\n" << imgWidth << " " << imgHeight << "\n255\n";
-    for (int y = 0; y < imgHeight; ++y) {
-        for (int x = 0; x < imgWidth; ++x) {
-            ofs << static_cast<int>(imageBuffer[y * imgWidth + x]) << " ";
+    if (started) {
+        // Close the strip: the rest of the trace plus the bottom margin
+        layout.imgHeight = layout.JulianToY(lastJulian) + layout.padding;
+        emitThrough(layout.imgHeight, true);
+    }
+    std::cerr << "Wrote " << rowsWritten << " rows of " << layout.imgWidth << " dots." << std::endl;
+    return 0;
+}
+
+// --- MAIN APPLICATION ---
+
+int main(int argc, char* argv[]) {
+    // 1. --- FILE HANDLING, PARSING, STATS, and CANVAS SETUP ---
+    std::string filename;
+    std::string outputFilename;
+    int bandHeight = 256;
+    ImageFormat format = ImageFormat::Pgm;
+    bool formatOk = true;
+    bool follow = false;
+    double clipPercent = 0.0;
+    double pixelsPerDay = PIXELS_PER_DAY;
+    FollowOptions followOptions;
+    PlotSeries series;
+    std::vector<std::string> fillSpecs;
+    bool seriesOk = true;
+    bool useCache = true;
+    JulianWindow window;
+    bool windowOk = true;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--band-height" && i + 1 < argc) {
+            bandHeight = std::atoi(argv[++i]);
+        }
+        else if (arg == "--format" && i + 1 < argc) {
+            formatOk = ParseImageFormat(argv[++i], format);
+        }
+        else if (arg == "--pixels-per-day" && i + 1 < argc) {
+            pixelsPerDay = std::atof(argv[++i]);
+        }
+        else if (arg == "--clip-percent" && i + 1 < argc) {
+            clipPercent = std::atof(argv[++i]);
+        }
+        else if (arg == "--output" && i + 1 < argc) {
+            outputFilename = argv[++i];
+        }
+        else if (arg == "--series" && i + 1 < argc) {
+            seriesOk = ParseSeriesList(argv[++i], series.columns) && seriesOk;
+        }
+        else if (arg == "--fill" && i + 1 < argc) {
+            fillSpecs.push_back(argv[++i]);
+        }
+        else if (arg == "--from" && i + 1 < argc) {
+            windowOk = ParseWindowBound(argv[++i], false, window.from) && windowOk;
         }
-        ofs << "\n";
+        else if (arg == "--to" && i + 1 < argc) {
+            windowOk = ParseWindowBound(argv[++i], true, window.to) && windowOk;
+        }
+        else if (arg == "--no-cache") {
+            useCache = false;
+        }
+        else if (arg == "--follow") {
+            follow = true;
+        }
+        else if (arg == "--poll-ms" && i + 1 < argc) {
+            followOptions.pollMs = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (arg == "--idle-exit" && i + 1 < argc) {
+            followOptions.idleExitSeconds = std::atof(argv[++i]);
+        }
+        else if (arg == "--scale-window" && i + 1 < argc) {
+            followOptions.scaleWindow = static_cast<size_t>(std::max(0, std::atoi(argv[++i])));
+        }
+        else if (filename.empty()) {
+            filename = arg;
+        }
+    }
+    // Fills name series, so they are resolved once the series are known
+    if (!fillSpecs.empty()) series.fills.clear();
+    for (const std::string& spec : fillSpecs) {
+        AreaFill fill;
+        if (spec == "none") continue;
+        if (!ParseFill(spec, series.columns, fill)) seriesOk = false;
+        series.fills.push_back(fill);
+    }
+    if (filename.empty() || !seriesOk || !windowOk || !(window.from < window.to) || (follow && window.limited()) || series.fills.size() > 3 || bandHeight < 0 || !formatOk || (follow && bandHeight == 0) || clipPercent < 0.0 || clipPercent >= 50.0 || !(pixelsPerDay > 0.0)) {
+        std::cerr << "Usage: " << argv[0] << " <solar_flux_data.csv|.txt> [--band-height <rows>] [--format pgm|pbm|png] [--pixels-per-day <n>] [--clip-percent <p>] [--output <file>]" << std::endl;
+        std::cerr << "           [--series <a>[,<b>...]] [--fill <a>[:<b>]|none ...] [--no-cache]" << std::endl;
+        std::cerr << "           [--from <YYYY-MM-DD|julian>] [--to <YYYY-MM-DD|julian>]" << std::endl;
+        std::cerr << "       " << argv[0] << " <solar_flux_data.csv|.txt> --follow [--output <file>|-] [--poll-ms <ms>] [--idle-exit <s>] [--scale-window <rows>]" << std::endl;
+        std::cerr << "  --band-height     Rows rendered per strip (default 256, 0 renders the whole canvas at once)" << std::endl;
+        std::cerr << "  --format          pgm: 8-bit grayscale (default), pbm: packed 1 bit per dot, png: 1-bit PNG" << std::endl;
+        std::cerr << "  --pixels-per-day  Time scale (default 10); samples sharing a row are reduced to first/min/max/last" << std::endl;
+        std::cerr << "  --clip-percent    Scale to the p..100-p percentile range instead of mean +/- 3 sigma" << std::endl;
+        std::cerr << "  --series          Flux columns to plot on one axis, e.g. obs,adj,ursi (default obs); the first" << std::endl;
+        std::cerr << "                    is a solid line, the second dashed, the third thin" << std::endl;
+        std::cerr << "  --fill            Hatch from the left edge to a series (<a>) or between two (<a>:<b>); up to" << std::endl;
+        std::cerr << "                    three, each with its own hatch, or none (default: from the left to the first)" << std::endl;
+        std::cerr << "  --no-cache        Parse the CSV even when an up-to-date <file>.fluxcache is next to it" << std::endl;
+        std::cerr << "  --from, --to      Plot only the rows from/to this date (inclusive) or Julian day; the CSV" << std::endl;
+        std::cerr << "                    is then read through <file>.fluxindex, built on first use" << std::endl;
+        std::cerr << "  --follow          Keep watching the file and emit plot rows as new data arrives," << std::endl;
+        std::cerr << "                    as raw 1-bit print rows (default output solar_flux_plot.raw)" << std::endl;
+        std::cerr << "  --poll-ms         Follow: longest wait between checks for new rows (default 1000)" << std::endl;
+        std::cerr << "  --idle-exit       Follow: finish the strip after this many seconds without new rows" << std::endl;
+        std::cerr << "  --scale-window    Follow: rescale from the last n rows instead of keeping the initial scale" << std::endl;
+        return 1;
+    }
+    if (follow) {
+        followOptions.bandHeight = bandHeight;
+        followOptions.clipPercent = clipPercent;
+        followOptions.pixelsPerDay = pixelsPerDay;
+        followOptions.series = series;
+        followOptions.outputFilename = outputFilename.empty() ? "solar_flux_plot.raw" : outputFilename;
+        return RunFollow(filename, followOptions);
+    }
+    // Every series comes from the same single parse, or from the cache.
+    FluxTable table;
+    FluxCache cache;
+    FluxSourceStamp stamp;
+    bool loaded = false;
+    std::string cacheFilename = FluxCachePath(filename);
+    if (useCache && cache.open(cacheFilename)) {
+        if (ReadSourceStamp(filename, stamp) && cache.matches(stamp)) {
+            LoadFluxCache(cache, series, window, table);
+            std::cout << "Read columns from cache '" << cacheFilename << "'" << std::endl;
+            loaded = true;
+        }
+        else {
+            std::cerr << "Note: '" << cacheFilename << "' is out of date; parsing the CSV (csv_converter --cache refreshes it)" << std::endl;
+        }
+        cache.close();
+    }
+    if (!loaded) {
+        // Stamped before mapping, so an index built from a file that changes
+        // meanwhile is stale next time rather than wrongly fresh
+        bool stamped = window.limited() && ReadSourceStamp(filename, stamp);
+        MappedFile dataFile;
+        if (!dataFile.open(filename)) {
+            std::cerr << "Error: Could not open file '" << filename << "'" << std::endl;
+            return 1;
+        }
+        // Past the header, and the dashes under it in fluxtable.txt
+        const char* rows;
+        FluxRowFormat rowFormat = DetectFluxRowFormat(dataFile.begin(), dataFile.end(), rows);
+        CsvLineReader reader(rows, dataFile.end());
+        std::string_view line;
+        bool sorted = false;
+        if (window.limited()) {
+            FluxIndex index;
+            std::string indexFilename = FluxIndexPath(filename);
+            if (!stamped || !index.load(indexFilename, stamp)) {
+                index.build(dataFile.begin(), dataFile.end(), stamp);
+                if (stamped && !index.save(indexFilename)) {
+                    std::cerr << "Note: Could not save index '" << indexFilename << "'" << std::endl;
+                }
+            }
+            sorted = index.sorted();
+            reader = CsvLineReader(dataFile.begin() + index.seek(window.from), dataFile.end());
+        }
+        while (reader.nextLine(line)) {
+            FluxRow row;
+            if (!ParseSolarRow(line, series, rowFormat, row)) continue;
+            if (sorted && row.julian >= window.to) break; // the rest are later still
+            if (window.contains(row.julian)) table.append(row, series);
+        }
+    }
+    if (table.size() == 0) {
+        std::cerr << "Error: No valid data points were read" << (window.limited() ? " in the --from/--to window." : ".") << std::endl;
+        return 1;
+    }
+    std::cout << "Successfully read " << table.size() << " data points." << std::endl;
+    // Row by row, in file order, whichever way the table was filled
+    FluxRangeEstimator scale(clipPercent);
+    for (size_t i = 0; i < table.size(); ++i) {
+        for (FluxColumn c : series.columns) scale.add(table.flux[c][i]);
+    }
+    PlotLayout layout;
+    scale.apply(layout);
+    std::cout << "Visual flux range set to: " << layout.visualMinFlux << " -> " << layout.visualMaxFlux << std::endl;
+    layout.imgWidth = PLOT_WIDTH;
+    layout.padding = PLOT_PADDING;
+    layout.startJulian = table.julian.front();
+    layout.timeRange = table.julian.back() - table.julian.front();
+    if (!(layout.timeRange > 0.0)) layout.timeRange = 1.0 / pixelsPerDay; // a single sample, e.g. a one-row window
+    layout.imgHeight = static_cast<int>(std::round(layout.timeRange * pixelsPerDay)) + (2 * layout.padding);
+    const int imgWidth = layout.imgWidth, imgHeight = layout.imgHeight;
+    if (bandHeight == 0 || bandHeight > imgHeight) bandHeight = imgHeight;
+
+    // 2. --- PRECOMPUTE GRIDLINES, TRACE, and OUTLIERS ---
+    std::vector<GridLine> gridLines;
+    AppendQuarterGridLines(gridLines, layout, table.julian.front(), table.julian.back());
+    std::vector<PlotTrace> traces;
+    std::vector<size_t> outliers;
+    BuildTraces(layout, table, series, traces, outliers);
+
+    // 3. --- RENDER BANDS and SAVE TO FILE ---
+    // Each band is written as soon as it is finished, so only one band of
+    // canvas is ever resident no matter how many years are plotted.
+    if (outputFilename.empty()) outputFilename = std::string("solar_flux_plot.") + ImageFormatExtension(format);
+    ImageWriter writer;
+    if (!writer.open(outputFilename, format, imgWidth, imgHeight)) {
+        std::cerr << "Error: Could not create output file '" << outputFilename << "'" << std::endl;
+        return 1;
+    }
+    int numBands = (imgHeight + bandHeight - 1) / bandHeight;
+    std::cout << "Rendering " << numBands << " band(s) of " << bandHeight << " rows..." << std::endl;
+    auto emit = [&](const auto& band) { writer.writeBand(band); };
+    if (ImageFormatIsMono(format)) {
+        // 1 bit per dot: every plot colour is pure black or white already.
+        RenderBands<MonoBitmap>(bandHeight, layout, table, series, traces, gridLines, outliers, emit);
+    }
+    else {
+        RenderBands<GrayBitmap>(bandHeight, layout, table, series, traces, gridLines, outliers, emit);
+    }
+    if (!writer.close()) {
+        std::cerr << "Error: Failed while writing '" << outputFilename << "'" << std::endl;
+        return 1;
     }
-    ofs.close();
     std::cout << "Success! flux plot saved to " << outputFilename << std::endl;
 
     return 0;
-}
\ No newline at end of file
+}
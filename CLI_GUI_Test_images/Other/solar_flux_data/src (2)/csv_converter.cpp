@@ -1,77 +1,110 @@
 // FILE: csv_converter.cpp
 // PURPOSE: Converts csv date-time Fields to proper date-time units for plotting.
-//          Removes all but fluxursi data.
+//          Removes all but fluxursi data. Reads fluxtable.csv or the
+//          fixed-column fluxtable.txt as downloaded (see flux_fixed_reader.h).
+//
+//          With --cache it also writes input.csv.fluxcache, every column of
+//          the input in binary (see flux_cache.h), which solar_flux_plot
+//          reads instead of parsing the CSV while the CSV is unchanged.
 //
 // AUTHOR: hamslices
 // ASSISTANCE: Major portions of this code were developed in collaboration with Google's AI.
 //
-// REQUIRES: "input.csv" in the same directory as the exe.
-// USAGE: ./csv_converter
+// REQUIRES: "input.csv" in the same directory as the exe (or a path on the
+//           command line); flux_csv_reader.h, flux_fixed_reader.h,
+//           flux_cache.h, flux_datetime.h and lark_parallel.h in ../../common.
+// USAGE: ./csv_converter [--threads <n>] [--cache] [input.csv|fluxtable.txt [output.csv]]
 
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <vector>
-#include <sstream>
 #include <cmath>
-#include <iomanip>
-
-// Extracts the date (YYYY-MM-DD) from a Julian Day number
-std::string julian_to_date(double julian_day) {
-    long long J = static_cast<long long>(julian_day + 0.5);
+#include <algorithm>
+
+#include "../../common/flux_csv_reader.h"
+#include "../../common/flux_fixed_reader.h"
+#include "../../common/flux_cache.h"
+#include "../../common/lark_parallel.h"
+#include "../../common/flux_datetime.h"
+
+// Converts every row in [begin, end) of the mapped input. Output lines and
+// warnings are appended to the chunk's own buffers so chunks can run on any
+// thread and still be written out in file order. With 'cache' set the
+// chunk's rows are also parsed into cache columns.
+struct ConvertedChunk { std::string text; std::string warnings; FluxCacheColumns cache; };
+
+void convert_chunk(const char* begin, const char* end, const FluxRowFormat& format, bool cache, ConvertedChunk& out) {
+    CsvLineReader reader(begin, end);
+    std::string_view line;
+    std::string_view row[7]; // Fields are trimmed views into the mapped file
+
+    while (reader.nextLine(line)) {
+        double values[FLUX_CACHE_COLUMNS];
+        if (cache && ParseFluxCacheRow(line, format, values)) out.cache.append(values);
+
+        if (format.split(line, row, 7) >= 7) {
+            double julian_day, carrington_rotation;
+            std::errc status = format.parse(row[2], julian_day);
+            if (status == std::errc()) status = format.parse(row[3], carrington_rotation);
+
+            if (status == std::errc() && !flux_date_in_range(julian_day)) {
+                out.warnings += "Warning: Skipping row with a date outside years 0000-9999.\n";
+            }
+            else if (status == std::errc()) {
+                char datetime[FLUX_DATETIME_CHARS];
+                format_flux_datetime(julian_day, carrington_rotation, datetime);
 
-    long long A;
-    if (J < 2299161) {
-        A = J;
-    }
-    else {
-        long long alpha = static_cast<long long>((J - 1867216.25) / 36524.25);
-        A = J + 1 + alpha - static_cast<long long>(alpha / 4);
+                out.text.append(datetime, FLUX_DATETIME_CHARS).append(",").append(row[6]).append("\n");
+            }
+            else if (status == std::errc::result_out_of_range) {
+                out.warnings += "Warning: Skipping row due to number out of range.\n";
+            }
+            else {
+                out.warnings += "Warning: Skipping row due to invalid number format.\n";
+            }
+        }
     }
-
-    long long B = A + 1524;
-    long long C = static_cast<long long>((B - 122.1) / 365.25);
-    long long D = static_cast<long long>(365.25 * C);
-    long long E = static_cast<long long>((B - D) / 30.6001);
-
-    int day = static_cast<int>(B - D - static_cast<long long>(30.6001 * E));
-    int month = (E < 14) ? static_cast<int>(E - 1) : static_cast<int>(E - 13);
-    int year = (month > 2) ? static_cast<int>(C - 4716) : static_cast<int>(C - 4715);
-
-    std::stringstream ss;
-    ss << std::setfill('0') << std::setw(4) << year << "-"
-        << std::setw(2) << month << "-"
-        << std::setw(2) << day;
-
-    return ss.str();
 }
 
-// Converts the fractional part of a Carrington Rotation to time (HH:MM:SS)
-std::string carrington_to_time(double carrington_rotation) {
-    double fraction = carrington_rotation - static_cast<long long>(carrington_rotation);
-    double total_seconds = fraction * 24.0 * 3600.0;
-
-    int hours = static_cast<int>(total_seconds / 3600);
-    total_seconds -= hours * 3600;
-    int minutes = static_cast<int>(total_seconds / 60);
-    int seconds = static_cast<int>(total_seconds - minutes * 60);
-
-    std::stringstream ss;
-    ss << std::setfill('0') << std::setw(2) << hours << ":"
-        << std::setw(2) << minutes << ":"
-        << std::setw(2) << seconds;
-
-    return ss.str();
-}
+int main(int argc, char* argv[]) {
+    std::string inputFilename = "input.csv";
+    std::string outputFilename = "output_final.csv";
+    unsigned threads = 1;
+    bool cache = false;
+    int positional = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            int n = std::atoi(argv[++i]);
+            threads = n > 0 ? static_cast<unsigned>(n) : DefaultThreadCount();
+        }
+        else if (arg == "--cache") {
+            cache = true;
+        }
+        else if (positional == 0) { inputFilename = arg; ++positional; }
+        else if (positional == 1) { outputFilename = arg; ++positional; }
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--threads <n>] [--cache] [input.csv|fluxtable.txt [output.csv]]" << std::endl;
+            std::cerr << "  --threads  Convert chunks on n worker threads (0 = one per core, default 1)" << std::endl;
+            std::cerr << "  --cache    Also write input.csv.fluxcache, the parsed columns for solar_flux_plot" << std::endl;
+            return 1;
+        }
+    }
 
-int main() {
-    std::ifstream inputFile("input.csv");
-    if (!inputFile.is_open()) {
+    // Stamped before reading, so a change made meanwhile leaves the cache stale
+    FluxSourceStamp stamp;
+    if (cache && !ReadSourceStamp(inputFilename, stamp)) {
+        std::cerr << "Error: Could not open input file." << std::endl;
+        return 1;
+    }
+    MappedFile inputFile;
+    if (!inputFile.open(inputFilename)) {
         std::cerr << "Error: Could not open input file." << std::endl;
         return 1;
     }
 
-    std::ofstream outputFile("output_final.csv");
+    std::ofstream outputFile(outputFilename, std::ios::out | std::ios::binary);
     if (!outputFile.is_open()) {
         std::cerr << "Error: Could not create output file." << std::endl;
         return 1;
@@ -79,44 +112,43 @@ int main() {
 
     outputFile << "datetime,fluxursi\n";
 
-    std::string line;
-    std::getline(inputFile, line); // Skip header
-
-    while (std::getline(inputFile, line)) {
-        std::stringstream ss(line);
-        std::string cell;
-        std::vector<std::string> row;
-
-        while (std::getline(ss, cell, ',')) {
-            // Trim whitespace
-            cell.erase(0, cell.find_first_not_of(" \t\n\r"));
-            cell.erase(cell.find_last_not_of(" \t\n\r") + 1);
-            row.push_back(cell);
-        }
+    // Skip the header, and the dashes under it in fluxtable.txt
+    const char* rows;
+    FluxRowFormat format = DetectFluxRowFormat(inputFile.begin(), inputFile.end(), rows);
+
+    // Split the rest of the file on line boundaries into ~1 MB chunks.
+    const size_t CHUNK_BYTES = 1 << 20;
+    std::vector<const char*> bounds{ rows };
+    while (bounds.back() < inputFile.end()) {
+        const char* cut = bounds.back() + std::min<size_t>(CHUNK_BYTES, inputFile.end() - bounds.back());
+        while (cut < inputFile.end() && cut[-1] != '\n') ++cut;
+        bounds.push_back(cut);
+    }
+    size_t chunkCount = bounds.size() - 1;
+
+    std::vector<ConvertedChunk> chunks(chunkCount);
+    FluxCacheColumns columns;
+    ParallelOrdered(chunkCount, threads, 2 * threads,
+        [&](size_t i) { convert_chunk(bounds[i], bounds[i + 1], format, cache, chunks[i]); },
+        [&](size_t i) {
+            std::cerr << chunks[i].warnings;
+            outputFile.write(chunks[i].text.data(), chunks[i].text.size());
+            columns.append(chunks[i].cache);
+            chunks[i] = ConvertedChunk(); // release the buffers
+        });
 
-        if (row.size() >= 7) {
-            try {
-                double julian_day = std::stod(row[2]);
-                double carrington_rotation = std::stod(row[3]);
+    outputFile.close();
 
-                std::string date_part = julian_to_date(julian_day);
-                std::string time_part = carrington_to_time(carrington_rotation);
+    std::cout << "CSV processing complete. Data saved to " << outputFilename << std::endl;
 
-                outputFile << date_part << " " << time_part << "," << row[6] << "\n";
-            }
-            catch (const std::invalid_argument& e) {
-                std::cerr << "Warning: Skipping row due to invalid number format." << std::endl;
-            }
-            catch (const std::out_of_range& e) {
-                std::cerr << "Warning: Skipping row due to number out of range." << std::endl;
-            }
+    if (cache) {
+        std::string cacheFilename = FluxCachePath(inputFilename);
+        if (!WriteFluxCache(cacheFilename, stamp, columns)) {
+            std::cerr << "Error: Could not write cache file '" << cacheFilename << "'." << std::endl;
+            return 1;
         }
+        std::cout << "Cached " << columns.size() << " rows in " << cacheFilename << std::endl;
     }
 
-    inputFile.close();
-    outputFile.close();
-
-    std::cout << "CSV processing complete. Data saved to output_final.csv" << std::endl;
-
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,567 @@
+// FILE: flux_bench.cpp
+// PURPOSE: Measures the solar flux ingest and formatting paths on real data.
+//          - Ingest: rows/sec for the original getline + stringstream parsers
+//            (as csv_converter and solar_flux_plot used them) next to the
+//            memory-mapped string_view + from_chars reader, and for reading
+//            the same columns back from a flux_cache.h binary cache.
+//          - Date/time: checks flux_datetime.h against the original
+//            stringstream julian_to_date / carrington_to_time (every day of
+//            years 0000-9999 plus every row of each file), parses every one
+//            of those dates back, and reports ns/call.
+//          - Stats: the one-pass mean/std dev and percentile sketch from
+//            lark_stats.h against a two-pass calculation and a full sort.
+//          - Fixed width: for fluxtable.txt, checks ParseFixedDouble against
+//            ParseFieldDouble bit for bit (every field, plus random strings)
+//            and reports MB/s for both over the fixed columns.
+//          - Raster: the span-filled lines, gridlines and hatch of
+//            lark_raster.h against the original brush-stamping versions,
+//            dot for dot on gray and 1-bit bands, and their speed.
+//
+// AUTHOR: hamslices
+//
+// REQUIRES: flux_csv_reader.h, flux_fixed_reader.h, flux_cache.h,
+//           flux_datetime.h, lark_stats.h and lark_raster.h (with
+//           lark_bitmap.h) in ../../common. The cache is written to the
+//           system temp folder.
+// USAGE: ./flux_bench ../fluxtable.csv ../fluxtable_short.csv ../fluxtable.txt
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <cmath>
+#include <random>
+#include <filesystem>
+
+#include "../../common/flux_csv_reader.h"
+#include "../../common/flux_fixed_reader.h"
+#include "../../common/flux_cache.h"
+#include "../../common/flux_datetime.h"
+#include "../../common/lark_stats.h"
+#include "../../common/lark_raster.h"
+
+// Row count and a checksum of the Julian and flux columns, so the paths can
+// be compared and the compiler cannot drop the parsing work.
+struct IngestResult { size_t rows = 0; double checksum = 0.0; };
+
+// --- ORIGINAL IMPLEMENTATIONS (reference) ---
+
+std::string reference_julian_to_date(double julian_day) {
+    long long J = static_cast<long long>(julian_day + 0.5);
+    long long A;
+    if (J < 2299161) {
+        A = J;
+    }
+    else {
+        long long alpha = static_cast<long long>((J - 1867216.25) / 36524.25);
+        A = J + 1 + alpha - static_cast<long long>(alpha / 4);
+    }
+    long long B = A + 1524;
+    long long C = static_cast<long long>((B - 122.1) / 365.25);
+    long long D = static_cast<long long>(365.25 * C);
+    long long E = static_cast<long long>((B - D) / 30.6001);
+    int day = static_cast<int>(B - D - static_cast<long long>(30.6001 * E));
+    int month = (E < 14) ? static_cast<int>(E - 1) : static_cast<int>(E - 13);
+    int year = (month > 2) ? static_cast<int>(C - 4716) : static_cast<int>(C - 4715);
+    std::stringstream ss;
+    ss << std::setfill('0') << std::setw(4) << year << "-"
+        << std::setw(2) << month << "-"
+        << std::setw(2) << day;
+    return ss.str();
+}
+
+std::string reference_carrington_to_time(double carrington_rotation) {
+    double fraction = carrington_rotation - static_cast<long long>(carrington_rotation);
+    double total_seconds = fraction * 24.0 * 3600.0;
+    int hours = static_cast<int>(total_seconds / 3600);
+    total_seconds -= hours * 3600;
+    int minutes = static_cast<int>(total_seconds / 60);
+    int seconds = static_cast<int>(total_seconds - minutes * 60);
+    std::stringstream ss;
+    ss << std::setfill('0') << std::setw(2) << hours << ":"
+        << std::setw(2) << minutes << ":"
+        << std::setw(2) << seconds;
+    return ss.str();
+}
+
+// csv_converter: getline, stringstream split, trimmed string cells, stod
+IngestResult IngestConverterStyle(const std::string& filename) {
+    IngestResult result;
+    std::ifstream inputFile(filename);
+    std::string line;
+    std::getline(inputFile, line);
+    while (std::getline(inputFile, line)) {
+        std::stringstream ss(line);
+        std::string cell;
+        std::vector<std::string> row;
+        while (std::getline(ss, cell, ',')) {
+            cell.erase(0, cell.find_first_not_of(" \t\n\r"));
+            cell.erase(cell.find_last_not_of(" \t\n\r") + 1);
+            row.push_back(cell);
+        }
+        if (row.size() >= 7) {
+            try {
+                result.checksum += std::stod(row[2]) + std::stod(row[6]);
+                ++result.rows;
+            }
+            catch (const std::exception&) {
+            }
+        }
+    }
+    return result;
+}
+
+// solar_flux_plot: replace commas, then stream-extract the numbers
+IngestResult IngestPlotterStyle(const std::string& filename) {
+    IngestResult result;
+    std::ifstream dataFile(filename);
+    std::string line;
+    std::getline(dataFile, line);
+    while (std::getline(dataFile, line)) {
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::stringstream ss(line);
+        std::string dummy;
+        double julian, carrington, flux, adjusted, ursi;
+        ss >> dummy >> dummy >> julian >> carrington >> flux >> adjusted >> ursi;
+        if (!ss.fail()) {
+            result.checksum += julian + ursi;
+            ++result.rows;
+        }
+    }
+    return result;
+}
+
+// --- MAPPED READER ---
+
+IngestResult IngestMapped(const std::string& filename) {
+    IngestResult result;
+    MappedFile file;
+    if (!file.open(filename)) return result;
+    CsvLineReader reader(file.begin(), file.end());
+    std::string_view line, fields[7];
+    reader.nextLine(line);
+    while (reader.nextLine(line)) {
+        if (SplitCsvFields(line, fields, 7) < 7) continue;
+        double julian, ursi;
+        if (ParseFieldDouble(fields[2], julian) == std::errc() && ParseFieldDouble(fields[6], ursi) == std::errc()) {
+            result.checksum += julian + ursi;
+            ++result.rows;
+        }
+    }
+    return result;
+}
+
+// --- BINARY CACHE ---
+
+// Parses every column of 'filename' into a cache, as csv_converter --cache does
+bool WriteBenchCache(const std::string& filename, const std::string& cacheFilename) {
+    FluxSourceStamp stamp;
+    MappedFile file;
+    if (!ReadSourceStamp(filename, stamp) || !file.open(filename)) return false;
+    FluxCacheColumns columns;
+    const char* rows;
+    FluxRowFormat format = DetectFluxRowFormat(file.begin(), file.end(), rows);
+    CsvLineReader reader(rows, file.end());
+    std::string_view line;
+    while (reader.nextLine(line)) {
+        double row[FLUX_CACHE_COLUMNS];
+        if (ParseFluxCacheRow(line, format, row)) columns.append(row);
+    }
+    return WriteFluxCache(cacheFilename, stamp, columns);
+}
+
+// The rows with an URSI value, as IngestMapped counts them
+IngestResult IngestCache(const std::string& cacheFilename) {
+    IngestResult result;
+    FluxCache cache;
+    if (!cache.open(cacheFilename)) return result;
+    const double* julian = cache.column(CACHE_JULIAN);
+    const double* ursi = cache.column(CACHE_URSI);
+    for (size_t i = 0; i < cache.rows(); ++i) {
+        if (std::isnan(ursi[i])) continue;
+        result.checksum += julian[i] + ursi[i];
+        ++result.rows;
+    }
+    return result;
+}
+
+// Runs fn repeatedly for at least half a second and reports the best pass.
+void Report(const std::string& name, const std::function<IngestResult()>& fn, const IngestResult& expected) {
+    using clock = std::chrono::steady_clock;
+    double best = 1e30;
+    IngestResult result;
+    auto start = clock::now();
+    int passes = 0;
+    do {
+        auto t0 = clock::now();
+        result = fn();
+        double seconds = std::chrono::duration<double>(clock::now() - t0).count();
+        best = std::min(best, seconds);
+        ++passes;
+    } while (std::chrono::duration<double>(clock::now() - start).count() < 0.5 || passes < 3);
+    bool match = result.rows == expected.rows && result.checksum == expected.checksum;
+    std::cout << "  " << std::left << std::setw(34) << name << std::right
+        << std::setw(12) << std::fixed << std::setprecision(0) << result.rows / best << " rows/sec"
+        << std::setw(10) << std::setprecision(2) << best * 1000.0 << " ms"
+        << (match ? "" : "  MISMATCH") << std::endl;
+}
+
+// --- DATE & TIME ---
+
+// Loads the Julian and Carrington columns of a file.
+void LoadTimeColumns(const std::string& filename, std::vector<double>& julian, std::vector<double>& carrington) {
+    MappedFile file;
+    if (!file.open(filename)) return;
+    CsvLineReader reader(file.begin(), file.end());
+    std::string_view line, fields[4];
+    reader.nextLine(line);
+    while (reader.nextLine(line)) {
+        double j, c;
+        if (SplitCsvFields(line, fields, 4) >= 4 && ParseFieldDouble(fields[2], j) == std::errc() && ParseFieldDouble(fields[3], c) == std::errc()) {
+            julian.push_back(j);
+            carrington.push_back(c);
+        }
+    }
+}
+
+// Every day number from 0000-01-01 to 9999-12-31, and a few outside. Returns
+// the mismatch count.
+size_t VerifyAllDays() {
+    size_t mismatches = 0;
+    char buf[FLUX_DATE_CHARS];
+    for (long long J = 1721058; J <= 5373484; ++J) {
+        format_julian_date(static_cast<double>(J), buf);
+        if (reference_julian_to_date(static_cast<double>(J)) != std::string(buf, FLUX_DATE_CHARS)) {
+            if (mismatches++ < 5) std::cerr << "  date mismatch at JDN " << J << std::endl;
+        }
+        long long parsed;
+        if (!parse_flux_date(std::string_view(buf, FLUX_DATE_CHARS), parsed) || parsed != J) {
+            if (mismatches++ < 5) std::cerr << "  parse_flux_date mismatch at JDN " << J << std::endl;
+        }
+    }
+    // Days the four-digit year cannot hold must not pass for real dates
+    for (double julian : { static_cast<double>(FLUX_FIRST_JDN) - 1.0, static_cast<double>(FLUX_LAST_JDN) + 1.0, -1e300, 1e300, std::nan("") }) {
+        format_julian_date(julian, buf);
+        if (std::string(buf, FLUX_DATE_CHARS) != FLUX_UNKNOWN_DATE && mismatches++ < 5) std::cerr << "  out-of-range date not flagged: " << julian << std::endl;
+    }
+    return mismatches;
+}
+
+size_t VerifyRows(const std::vector<double>& julian, const std::vector<double>& carrington) {
+    size_t mismatches = 0;
+    char buf[FLUX_DATETIME_CHARS];
+    for (size_t i = 0; i < julian.size(); ++i) {
+        format_flux_datetime(julian[i], carrington[i], buf);
+        std::string expected = reference_julian_to_date(julian[i]) + " " + reference_carrington_to_time(carrington[i]);
+        if (expected != std::string(buf, FLUX_DATETIME_CHARS)) {
+            if (mismatches++ < 5) std::cerr << "  datetime mismatch: " << expected << std::endl;
+        }
+    }
+    return mismatches;
+}
+
+// Best-of-several timing of fn over all rows, in ns per row.
+double TimePerRow(size_t rows, const std::function<void()>& fn) {
+    using clock = std::chrono::steady_clock;
+    double best = 1e30;
+    auto start = clock::now();
+    int passes = 0;
+    do {
+        auto t0 = clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double>(clock::now() - t0).count());
+        ++passes;
+    } while (std::chrono::duration<double>(clock::now() - start).count() < 0.5 || passes < 3);
+    return best * 1e9 / rows;
+}
+
+void ReportDateTime(const std::string& filename) {
+    std::vector<double> julian, carrington;
+    LoadTimeColumns(filename, julian, carrington);
+    size_t mismatches = VerifyRows(julian, carrington);
+    std::cout << "  datetime check: " << julian.size() << " rows, " << mismatches << " mismatches" << std::endl;
+
+    volatile size_t sink = 0; // keeps the formatted output observable
+    double reference = TimePerRow(julian.size(), [&] {
+        for (size_t i = 0; i < julian.size(); ++i) {
+            sink = sink + reference_julian_to_date(julian[i]).size() + reference_carrington_to_time(carrington[i]).size();
+        }
+    });
+    char buf[FLUX_DATETIME_CHARS];
+    double single = TimePerRow(julian.size(), [&] {
+        for (size_t i = 0; i < julian.size(); ++i) {
+            format_flux_datetime(julian[i], carrington[i], buf);
+            sink = sink + static_cast<unsigned char>(buf[18]);
+        }
+    });
+    std::vector<char> out(julian.size() * FLUX_DATETIME_CHARS);
+    double batch = TimePerRow(julian.size(), [&] {
+        format_flux_datetimes(julian.data(), carrington.data(), julian.size(), out.data());
+        sink = sink + static_cast<unsigned char>(out.back());
+    });
+    std::cout << std::fixed << std::setprecision(1)
+        << "  stringstream julian_to_date + carrington_to_time " << std::setw(8) << reference << " ns/row" << std::endl
+        << "  format_flux_datetime                             " << std::setw(8) << single << " ns/row" << std::endl
+        << "  format_flux_datetimes (batch)                    " << std::setw(8) << batch << " ns/row" << std::endl;
+}
+
+// --- STATISTICS ---
+
+void ReportStats(const std::string& filename) {
+    std::vector<double> flux;
+    MappedFile file;
+    if (!file.open(filename)) return;
+    CsvLineReader reader(file.begin(), file.end());
+    std::string_view line, fields[5];
+    reader.nextLine(line);
+    while (reader.nextLine(line)) {
+        double f;
+        if (SplitCsvFields(line, fields, 5) >= 5 && ParseFieldDouble(fields[4], f) == std::errc()) flux.push_back(f);
+    }
+    if (flux.empty()) return;
+
+    RunningStats stats;
+    QuantileSketch sketch;
+    for (double f : flux) {
+        stats.add(f);
+        sketch.add(f);
+    }
+    double sum = 0.0;
+    for (double f : flux) sum += f;
+    double mean = sum / flux.size();
+    double sum_sq_diff = 0.0;
+    for (double f : flux) sum_sq_diff += (f - mean) * (f - mean);
+    double std_dev = std::sqrt(sum_sq_diff / flux.size());
+    std::cout << std::setprecision(6) << std::defaultfloat
+        << "  mean " << stats.mean() << " (two-pass " << mean << "), std dev " << stats.stdDev() << " (two-pass " << std_dev << ")" << std::endl;
+
+    std::sort(flux.begin(), flux.end());
+    double worst = 0.0;
+    for (double q : { 0.005, 0.01, 0.05, 0.5, 0.95, 0.99, 0.995 }) {
+        double exact = flux[static_cast<size_t>(q * (flux.size() - 1))];
+        if (exact != 0.0) worst = std::max(worst, std::abs(sketch.quantile(q) - exact) / std::abs(exact));
+    }
+    std::cout << "  percentile sketch: worst relative error " << std::fixed << std::setprecision(2) << worst * 100.0 << "% (bound 0.50%)" << std::endl;
+}
+
+// --- FIXED WIDTH ---
+
+// Both parsers on one field; false if the results differ in any bit
+bool SameParse(std::string_view field) {
+    double a = 0.0, b = 0.0;
+    std::errc ea = ParseFixedDouble(field, a);
+    std::errc eb = ParseFieldDouble(field, b);
+    if (ea != eb) return false;
+    return ea != std::errc() || std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+// Every field of the file, then random strings of digits with a sprinkle of
+// the characters that must take the slow path. Returns the mismatches.
+size_t VerifyFixedNumbers(const MappedFile& file, const FluxRowFormat& format, const char* rows) {
+    size_t mismatches = 0;
+    CsvLineReader reader(rows, file.end());
+    std::string_view line, fields[7];
+    while (reader.nextLine(line)) {
+        size_t count = std::min<size_t>(format.split(line, fields, 7), 7);
+        for (size_t i = 0; i < count; ++i) {
+            if (!SameParse(fields[i]) && mismatches++ < 5) std::cerr << "  fixed parse mismatch: '" << fields[i] << "'" << std::endl;
+        }
+    }
+    std::mt19937 rng(2024);
+    const char alphabet[] = "0123456789012345678901234567890123456789..+-eE x";
+    char text[20];
+    for (int n = 0; n < 2000000; ++n) {
+        size_t size = 1 + rng() % 18;
+        for (size_t i = 0; i < size; ++i) text[i] = alphabet[rng() % (sizeof(alphabet) - 1)];
+        if (!SameParse(std::string_view(text, size)) && mismatches++ < 5) {
+            std::cerr << "  fixed parse mismatch: '" << std::string(text, size) << "'" << std::endl;
+        }
+    }
+    return mismatches;
+}
+
+// Every number of every row, as the converter's cache reads them
+template <typename Parse>
+IngestResult IngestFixed(const MappedFile& file, const FluxRowFormat& format, const char* rows, Parse parse) {
+    IngestResult result;
+    CsvLineReader reader(rows, file.end());
+    std::string_view line, fields[7];
+    while (reader.nextLine(line)) {
+        if (format.split(line, fields, 7) < 7) continue;
+        double values[5];
+        bool ok = true;
+        for (int i = 0; i < 5; ++i) ok = parse(fields[2 + i], values[i]) == std::errc() && ok;
+        if (!ok) continue;
+        result.checksum += values[0] + values[4];
+        ++result.rows;
+    }
+    return result;
+}
+
+void ReportFixed(const std::string& filename) {
+    MappedFile file;
+    if (!file.open(filename)) return;
+    const char* rows;
+    FluxRowFormat format = DetectFluxRowFormat(file.begin(), file.end(), rows);
+    std::cout << "  fixed-width check: " << format.columns.spans.size() << " columns, "
+        << VerifyFixedNumbers(file, format, rows) << " mismatches" << std::endl;
+    auto time = [&](const std::string& name, auto parse) {
+        double best = 1e30;
+        IngestResult result;
+        auto start = std::chrono::steady_clock::now();
+        int passes = 0;
+        do {
+            auto t0 = std::chrono::steady_clock::now();
+            result = IngestFixed(file, format, rows, parse);
+            best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+            ++passes;
+        } while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < 0.5 || passes < 3);
+        std::cout << "  " << std::left << std::setw(34) << name << std::right
+            << std::setw(12) << std::fixed << std::setprecision(0) << result.rows / best << " rows/sec"
+            << std::setw(10) << std::setprecision(1) << file.size() / best / 1e6 << " MB/s" << std::endl;
+        return result;
+    };
+    IngestResult slow = time("fixed columns + from_chars", [](std::string_view f, double& v) { return ParseFieldDouble(f, v); });
+    IngestResult fast = time("fixed columns + plain decimals", [](std::string_view f, double& v) { return ParseFixedDouble(f, v); });
+    if (slow.rows != fast.rows || slow.checksum != fast.checksum) std::cout << "  MISMATCH" << std::endl;
+}
+
+// --- RASTER ---
+
+// solar_flux_plot before lark_raster.h: a thickness x thickness brush
+// stamped at every dot of the Bresenham line, each dot bounds-checked.
+template <typename Bitmap>
+void ReferenceDashedLine(Bitmap& band, int x1, int y1, int x2, int y2, int thickness, unsigned char color, int dash, int gap) {
+    int half = thickness / 2, total = dash + gap;
+    int dx = std::abs(x2 - x1), sx = x1 < x2 ? 1 : -1, dy = -std::abs(y2 - y1), sy = y1 < y2 ? 1 : -1, err = dx + dy, e2, len = 0;
+    while (true) {
+        if (gap == 0 || (len % total) < dash) {
+            for (int by = y1 - half; by <= y1 + half; ++by) {
+                for (int bx = x1 - half; bx <= x1 + half; ++bx) {
+                    if (band.Contains(bx, by)) band.Set(bx, by, color);
+                }
+            }
+        }
+        if (x1 == x2 && y1 == y2) break;
+        e2 = 2 * err;
+        if (e2 >= dy) { err += dy; x1 += sx; }
+        if (e2 <= dx) { err += dx; y1 += sy; }
+        len++;
+    }
+}
+
+template <typename Bitmap>
+void ReferenceHatchSpan(Bitmap& band, int x0, int x1, int y, int spacing, unsigned char color) {
+    for (int x = x0; x < x1; ++x) {
+        if ((x + y) % spacing == 0) band.Set(x, y, color);
+    }
+}
+
+// A band's worth of plot layers: dashed gridlines both ways, a random walk
+// for the trace (short segments, as the plot draws them), longer random
+// lines of every thickness and dash, and the hatch under the trace.
+struct RasterScene {
+    struct Line { int x1, y1, x2, y2, thickness, dash, gap; };
+    std::vector<Line> lines;
+    std::vector<std::pair<int, int>> hatch; // right end of the hatch on each row, from x = 200
+};
+
+RasterScene MakeRasterScene(int width, int height, uint32_t seed) {
+    RasterScene scene;
+    std::mt19937 rng(seed);
+    for (int x = 200; x <= width - 200; x += 132) scene.lines.push_back({ x, -50, x, height + 50, 1, 5, 5 });
+    for (int y = 0; y < height; y += 91) scene.lines.push_back({ 200, y, width - 200, y, 1, 5, (y / 91) % 4 == 0 ? 0 : 5 });
+    int x = width / 2;
+    for (int y = -10; y < height + 10; ) {
+        int nx = std::clamp(x + static_cast<int>(rng() % 61) - 30, 200, width - 200), ny = y + static_cast<int>(rng() % 4);
+        scene.lines.push_back({ x, y, nx, ny, 3, 1, 0 });
+        x = nx;
+        y = ny;
+    }
+    for (int i = 0; i < 400; ++i) {
+        int gap = rng() % 2 ? 0 : 1 + static_cast<int>(rng() % 6);
+        scene.lines.push_back({ static_cast<int>(rng() % (width + 100)) - 50, static_cast<int>(rng() % (height + 100)) - 50,
+            static_cast<int>(rng() % (width + 100)) - 50, static_cast<int>(rng() % (height + 100)) - 50,
+            1 + static_cast<int>(rng() % 6), 1 + static_cast<int>(rng() % 6), gap });
+    }
+    for (int y = 0; y < height; ++y) scene.hatch.push_back({ y, 200 + static_cast<int>(rng() % (width - 400)) });
+    return scene;
+}
+
+// Draws the scene both ways on bands of 'Bitmap' and returns the number of
+// rows that differ.
+template <typename Bitmap>
+size_t ReportRaster(const std::string& name) {
+    const int width = 1728, height = 512;
+    RasterScene scene = MakeRasterScene(width, height, 12345);
+    Bitmap reference(width, height, 0), raster(width, height, 0);
+    const FillPattern hatch = FillPattern::Hatch(8);
+
+    auto drawReference = [&] {
+        for (const auto& h : scene.hatch) ReferenceHatchSpan(reference, 200, h.second, h.first, 8, 0);
+        for (const auto& l : scene.lines) ReferenceDashedLine(reference, l.x1, l.y1, l.x2, l.y2, l.thickness, 0, l.dash, l.gap);
+    };
+    auto drawRaster = [&] {
+        for (const auto& h : scene.hatch) FillPatternSpan(raster, 200, h.second, h.first, hatch, 0);
+        for (const auto& l : scene.lines) DrawDashedLine(raster, l.x1, l.y1, l.x2, l.y2, l.thickness, 0, l.dash, l.gap);
+    };
+    reference.Clear(255);
+    raster.Clear(255);
+    drawReference();
+    drawRaster();
+    size_t mismatches = 0;
+    for (int y = 0; y < height; ++y) {
+        if (!std::equal(reference.Row(y), reference.Row(y) + reference.Stride(), raster.Row(y))) ++mismatches;
+    }
+
+    double before = TimePerRow(height, [&] { reference.Clear(255); drawReference(); });
+    double after = TimePerRow(height, [&] { raster.Clear(255); drawRaster(); });
+    std::cout << "  " << std::left << std::setw(6) << name << std::right << std::fixed << std::setprecision(1)
+        << " brush stamping " << std::setw(8) << before << " ns/row, lark_raster " << std::setw(8) << after
+        << " ns/row, " << mismatches << " rows differ" << std::endl;
+    return mismatches;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <fluxtable.csv> [more.csv ...]" << std::endl;
+        return 1;
+    }
+    size_t dayMismatches = VerifyAllDays();
+    std::cout << "Date check, every day of years 0000-9999: " << dayMismatches << " mismatches" << std::endl;
+    for (int i = 1; i < argc; ++i) {
+        std::string filename = argv[i];
+        MappedFile probe;
+        const char* rows;
+        if (probe.open(filename) && DetectFluxRowFormat(probe.begin(), probe.end(), rows).fixed()) {
+            // fluxtable.txt: the CSV readers above do not apply
+            std::cout << filename << " (fixed width)" << std::endl;
+            ReportFixed(filename);
+            continue;
+        }
+        IngestResult expected = IngestMapped(filename);
+        if (expected.rows == 0) {
+            std::cerr << "Error: No rows read from '" << filename << "'" << std::endl;
+            return 1;
+        }
+        std::cout << filename << " (" << expected.rows << " rows)" << std::endl;
+        Report("getline + stringstream + stod", [&] { return IngestConverterStyle(filename); }, expected);
+        Report("replace + stringstream >>", [&] { return IngestPlotterStyle(filename); }, expected);
+        Report("mmap + string_view + from_chars", [&] { return IngestMapped(filename); }, expected);
+        std::string cacheFilename = (std::filesystem::temp_directory_path() / "flux_bench.fluxcache").string();
+        if (WriteBenchCache(filename, cacheFilename)) {
+            Report("binary cache (flux_cache.h)", [&] { return IngestCache(cacheFilename); }, expected);
+            std::remove(cacheFilename.c_str());
+        }
+        ReportDateTime(filename);
+        ReportStats(filename);
+    }
+    std::cout << "Raster (1728-dot bands)" << std::endl;
+    if (ReportRaster<GrayBitmap>("gray") + ReportRaster<MonoBitmap>("1-bit") > 0) return 1;
+    return 0;
+}